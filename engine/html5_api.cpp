@@ -1,43 +1,54 @@
 #include "html5_api.h"
+#include "html5_api_bindings.h"
+#include "html5_api_profiler.h"
 #include "stingray_api.h"
 
 #include <include/cef_app.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace PLUGIN_NAMESPACE {
 
-void bind_api(CefRefPtr<CefV8Value> stingray_ns)
-{
-	bind_api_fs(stingray_ns);
-	bind_api_host(stingray_ns);
-	bind_api_web_app(stingray_ns);
-	bind_api_web_view(stingray_ns);
-	bind_api_math(stingray_ns);
-	bind_api_application(stingray_ns, stingray::api::script->Application);
-	bind_api_world(stingray_ns, stingray::api::script->World);
-	bind_api_input(stingray_ns, stingray::api::script->Input);
-	bind_api_unit(stingray_ns, stingray::api::script->Unit);
-	bind_api_camera(stingray_ns, stingray::api::script->Camera);
-	bind_api_window(stingray_ns, stingray::api::script->Window);
-	bind_api_level(stingray_ns, stingray::api::script->Level);
-	bind_api_gui(stingray_ns, stingray::api::script->Gui);
+typedef void (*ApiBinder)(CefRefPtr<CefV8Value> stingray_ns);
+
+// Every binder adds one or more namespaces to the `stingray` object.
+static const ApiBinder api_binders[] = {
+	[](CefRefPtr<CefV8Value> ns) { bind_api_fs(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_host(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_profiler(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_web_app(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_web_view(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_math(ns); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_application(ns, stingray::api::script->Application); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_world(ns, stingray::api::script->World); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_input(ns, stingray::api::script->Input); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_unit(ns, stingray::api::script->Unit); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_camera(ns, stingray::api::script->Camera); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_window(ns, stingray::api::script->Window); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_level(ns, stingray::api::script->Level); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_gui(ns, stingray::api::script->Gui); },
+
+	// Generated bindings, see tools/bindgen.rb
+	[](CefRefPtr<CefV8Value> ns) { bind_api_material(ns, stingray::api::script->Material); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_mesh(ns, stingray::api::script->Mesh); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_physics_world(ns, stingray::api::script->PhysicsWorld); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_actor(ns, stingray::api::script->Actor); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_mover(ns, stingray::api::script->Mover); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_viewport(ns, stingray::api::script->Viewport); },
+	[](CefRefPtr<CefV8Value> ns) { bind_api_line_object(ns, stingray::api::script->LineObject); },
 	/* TODO
 	 struct DynamicScriptDataCApi* DynamicScriptData;
 
 	// C- API
-	struct MaterialCApi* Material;
 	struct LanCApi* Lan;
 	struct NetworkCApi* Network;
 	struct GameSessionCApi* GameSession;
 	struct UnitSynchronizerCApi* UnitSynchronizer;
 	struct UtilitiesCApi* Utilities;
 	struct EntityCApi* Entity;
-	struct LineObjectCApi* LineObject;
-	struct PhysicsWorldCApi* PhysicsWorld;
-	struct ActorCApi* Actor;
-	struct MoverCApi* Mover;
 	struct SaveSystemCApi* SaveSystem;
-	struct ViewportCApi* Viewport;
-	struct MeshCApi* Mesh;
 
 	// Engine API
 	RESOURCE_MANAGER_API_ID =			5,  // ResourceManagerApi
@@ -62,6 +73,186 @@ void bind_api(CefRefPtr<CefV8Value> stingray_ns)
 	CAMERA_API_ID =						38, // CameraApi
 
 	*/
+};
+
+// Namespace description shared by all contexts. Namespaces only made of handler functions are
+// recreated from their handlers, others (i.e. interceptor based arrays) rerun their binder.
+struct ApiNamespace
+{
+	unsigned binder;
+	bool shared;
+	std::vector<std::pair<std::string, CefRefPtr<CefV8Handler>>> functions;
+	// Functions using the engine, mirrored in `stingray.async`
+	std::vector<std::pair<std::string, CefRefPtr<CefV8Handler>>> engine_functions;
+	std::vector<std::pair<std::string, CefRefPtr<CefV8Handler>>> async_functions;
+};
+
+typedef std::unordered_map<std::string, ApiNamespace> ApiNamespaceMap;
+static ApiNamespaceMap* api_namespaces = nullptr;
+
+#if defined(DEVELOPMENT)
+	static double elapsed_ms(uint64_t start_ticks)
+	{
+		return stingray::api::timer->ticks_to_seconds(stingray::api::timer->ticks() - start_ticks) * 1000.0;
+	}
+
+	// Running every binder is what binding a context used to cost, reported next to the lazy binding time.
+	static double eager_bind_ms = 0.0;
+#endif
+
+static void build_api_namespaces()
+{
+	#if defined(DEVELOPMENT)
+		const uint64_t start_ticks = stingray::api::timer->ticks();
+	#endif
+
+	api_namespaces = new ApiNamespaceMap();
+	for (unsigned i = 0; i < sizeof(api_binders) / sizeof(api_binders[0]); ++i) {
+		CefRefPtr<CefV8Value> scratch_ns = CefV8Value::CreateObject(nullptr, nullptr);
+		api_binders[i](scratch_ns);
+
+		std::vector<CefString> names;
+		scratch_ns->GetKeys(names);
+		for (const auto& name : names) {
+			CefRefPtr<CefV8Value> ns = scratch_ns->GetValue(name);
+			ApiNamespace& api_ns = (*api_namespaces)[name.ToString()];
+			api_ns.binder = i;
+			api_ns.shared = false;
+
+			std::vector<CefString> function_names;
+			if (!ns->IsObject() || !ns->GetKeys(function_names) || function_names.empty())
+				continue;
+
+			api_ns.shared = true;
+			for (const auto& function_name : function_names) {
+				CefRefPtr<CefV8Value> function = ns->GetValue(function_name);
+				CefRefPtr<CefV8Handler> handler = function->IsFunction() ? function->GetFunctionHandler() : nullptr;
+				if (handler == nullptr) {
+					api_ns.shared = false;
+					api_ns.functions.clear();
+					api_ns.engine_functions.clear();
+					break;
+				}
+				api_ns.functions.push_back(std::make_pair(function_name.ToString(), handler));
+				if (!is_local_api_handler(handler))
+					api_ns.engine_functions.push_back(api_ns.functions.back());
+			}
+
+			for (const auto& function : api_ns.functions)
+				name_api_function(function.second.get(), name.ToString() + "." + function.first);
+		}
+	}
+
+	#if defined(DEVELOPMENT)
+		eager_bind_ms = elapsed_ms(start_ticks);
+		stingray::api::log->info("HTML5", stingray::api::error->eprintf("Built %u stingray namespaces in %.3f ms",
+			(unsigned)api_namespaces->size(), eager_bind_ms));
+	#endif
+}
+
+static CefRefPtr<CefV8Value> create_api_namespace(const std::string& name, ApiNamespace& api_ns, bool async)
+{
+	if (!api_ns.shared) {
+		// Only function tables using the engine have an async variant.
+		if (async)
+			return CefV8Value::CreateUndefined();
+		CefRefPtr<CefV8Value> scratch_ns = CefV8Value::CreateObject(nullptr, nullptr);
+		api_binders[api_ns.binder](scratch_ns);
+		return scratch_ns->GetValue(name);
+	}
+
+	if (async && api_ns.engine_functions.empty())
+		return CefV8Value::CreateUndefined();
+
+	if (async && api_ns.async_functions.empty()) {
+		for (const auto& function : api_ns.engine_functions)
+			api_ns.async_functions.push_back(std::make_pair(function.first, create_async_handler(function.second)));
+	}
+
+	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr);
+	for (const auto& function : async ? api_ns.async_functions : api_ns.functions)
+		ns->SetValue(function.first, CefV8Value::CreateFunction(function.first, function.second), V8_PROPERTY_ATTRIBUTE_READONLY);
+	return ns;
+}
+
+static CefRefPtr<CefV8Value> create_api_root(bool async);
+
+// Materializes the namespaces of a context the first time they are accessed.
+class ApiNamespaceAccessor : public CefV8Accessor
+{
+public:
+	explicit ApiNamespaceAccessor(bool async) : _async(async) {}
+
+	bool Get(const CefString& name, const CefRefPtr<CefV8Value> object, CefRefPtr<CefV8Value>& retval, CefString& exception) OVERRIDE
+	{
+		const std::string key = name.ToString();
+		auto it = _namespaces.find(key);
+		if (it != _namespaces.end()) {
+			retval = it->second;
+			return true;
+		}
+
+		if (!_async && key == "async") {
+			retval = create_api_root(true);
+		} else {
+			auto api_ns = api_namespaces->find(key);
+			if (api_ns == api_namespaces->end())
+				return false;
+			retval = create_api_namespace(key, api_ns->second, _async);
+		}
+
+		_namespaces[key] = retval;
+		return true;
+	}
+
+	bool Set(const CefString& name, const CefRefPtr<CefV8Value> object, const CefRefPtr<CefV8Value> value, CefString& exception) OVERRIDE
+	{
+		// Namespaces are read-only.
+		return true;
+	}
+
+private:
+	bool _async;
+	std::unordered_map<std::string, CefRefPtr<CefV8Value>> _namespaces;
+	IMPLEMENT_REFCOUNTING(ApiNamespaceAccessor);
+};
+
+// Creates the `stingray` object, or its `stingray.async` mirror where functions return promises.
+static CefRefPtr<CefV8Value> create_api_root(bool async)
+{
+	CefRefPtr<CefV8Value> root_ns = CefV8Value::CreateObject(new ApiNamespaceAccessor(async), nullptr);
+	for (const auto& api_ns : *api_namespaces) {
+		if (!async || !api_ns.second.engine_functions.empty())
+			root_ns->SetValue(api_ns.first, V8_ACCESS_CONTROL_DEFAULT, V8_PROPERTY_ATTRIBUTE_READONLY);
+	}
+	if (!async)
+		root_ns->SetValue("async", V8_ACCESS_CONTROL_DEFAULT, V8_PROPERTY_ATTRIBUTE_READONLY);
+	return root_ns;
+}
+
+CefRefPtr<CefV8Value> bind_api()
+{
+	if (api_namespaces == nullptr)
+		build_api_namespaces();
+
+	#if defined(DEVELOPMENT)
+		const uint64_t start_ticks = stingray::api::timer->ticks();
+	#endif
+
+	CefRefPtr<CefV8Value> stingray_ns = create_api_root(false);
+
+	#if defined(DEVELOPMENT)
+		stingray::api::log->info("HTML5", stingray::api::error->eprintf("Bound stingray API in %.3f ms, eager binding took %.3f ms",
+			elapsed_ms(start_ticks), eager_bind_ms));
+	#endif
+
+	return stingray_ns;
+}
+
+void unbind_api()
+{
+	delete api_namespaces;
+	api_namespaces = nullptr;
 }
 
 } // end namespace
@@ -7,17 +7,39 @@
 namespace PLUGIN_NAMESPACE {
 
 // WebApp/Engine sync APIs
+enum SyncTimeoutPolicy
+{
+	SYNC_TIMEOUT_SKIP,	// Stop waiting and let the engine frame continue.
+	SYNC_TIMEOUT_LOG	// Report the missed deadline and keep waiting.
+};
+void setup_sync();
+void shutdown_sync();
+void set_sync_deadline(unsigned deadline_ms, SyncTimeoutPolicy policy);
 void set_signal();
 void sync_signal();
-void wait_for_sync();
-struct SyncEngine { SyncEngine() { set_signal(); } ~SyncEngine() { wait_for_sync(); } };
+bool wait_for_sync();
+
+// Pipelined web apps sync once per engine frame, see WebApp.set_pipelined. Ending the sync also
+// applies the writes pages queued while the engine ran its frame.
+void set_web_app_pipelined(int browser_id, bool pipelined);
+void begin_pipelined_sync();
+void end_pipelined_sync();
+struct SyncEngine { SyncEngine() { set_signal(); } ~SyncEngine() { wait_for_sync(); end_pipelined_sync(); } };
 
 // Stingray Web API Lua bindings
 void load_lua_api(LuaApi* env);
 void unload_lua_api(LuaApi* env);
 
 // Stingray API JavaScript bindings
-void bind_api(CefRefPtr<CefV8Value> stingray_ns);
+CefRefPtr<CefV8Value> bind_api();
+void unbind_api();
+
+// Async `stingray.async.*` calls, queued by the page and run in batches at the engine frame boundary.
+CefRefPtr<CefV8Handler> create_async_handler(CefRefPtr<CefV8Handler> handler);
+void flush_async_api_calls();
+void set_async_api_batch_size(unsigned batch_size);
+void release_async_api_calls(CefRefPtr<CefV8Context> context);
+
 void bind_api_web_app(CefRefPtr<CefV8Value> stingray_ns);
 void bind_api_web_view(CefRefPtr<CefV8Value> stingray_ns);
 void bind_api_host(CefRefPtr<CefV8Value> stingray_ns);
@@ -30,6 +52,14 @@ void bind_api_camera(CefRefPtr<CefV8Value> stingray_ns, const CameraCApi* api);
 void bind_api_window(CefRefPtr<CefV8Value> stingray_ns, const WindowCApi* api);
 void bind_api_level(CefRefPtr<CefV8Value> stingray_ns, const LevelCApi* api);
 void bind_api_gui(CefRefPtr<CefV8Value> stingray_ns, const GuiCApi* api);
+void bind_api_material(CefRefPtr<CefV8Value> stingray_ns, const MaterialCApi* api);
+void bind_api_mesh(CefRefPtr<CefV8Value> stingray_ns, const MeshCApi* api);
+void bind_api_physics_world(CefRefPtr<CefV8Value> stingray_ns, const PhysicsWorldCApi* api);
+void bind_api_actor(CefRefPtr<CefV8Value> stingray_ns, const ActorCApi* api);
+void bind_api_mover(CefRefPtr<CefV8Value> stingray_ns, const MoverCApi* api);
+void bind_api_viewport(CefRefPtr<CefV8Value> stingray_ns, const ViewportCApi* api);
+void bind_api_line_object(CefRefPtr<CefV8Value> stingray_ns, const LineObjectCApi* api);
 void bind_api_fs(CefRefPtr<CefV8Value> stingray_ns);
+void bind_api_profiler(CefRefPtr<CefV8Value> stingray_ns);
 
 }
@@ -0,0 +1,58 @@
+// Generated by tools/bindgen.rb from c_api_actor.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb actor`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_actor(CefRefPtr<CefV8Value> stingray_ns, const ActorCApi* api)
+{
+	DEFINE_API("Actor");
+
+	BIND_API(is_collision_enabled);
+	BIND_API(is_scene_query_enabled);
+	BIND_API(is_gravity_enabled);
+	BIND_API(set_collision_enabled);
+	BIND_API(set_scene_query_enabled);
+	BIND_API(set_gravity_enabled);
+	BIND_API(is_static);
+	BIND_API(is_dynamic);
+	BIND_API(is_physical);
+	BIND_API(is_kinematic);
+	BIND_API(set_kinematic);
+	BIND_API(mass);
+	BIND_API(linear_damping);
+	BIND_API(angular_damping);
+	BIND_API(set_linear_damping);
+	BIND_API(set_angular_damping);
+	BIND_API(center_of_mass);
+	BIND_API(position);
+	BIND_API(rotation);
+	BIND_API(pose);
+	BIND_API(teleport_position);
+	BIND_API(teleport_rotation);
+	BIND_API(teleport_pose);
+	BIND_API(set_velocity);
+	BIND_API(set_angular_velocity);
+	BIND_API(velocity);
+	BIND_API(angular_velocity);
+	BIND_API(point_velocity);
+	BIND_API(add_impulse);
+	BIND_API(add_velocity);
+	BIND_API(add_torque_impulse);
+	BIND_API(add_angular_velocity);
+	BIND_API(add_impulse_at);
+	BIND_API(add_velocity_at);
+	BIND_API(push);
+	BIND_API(push_at);
+	BIND_API(is_sleeping);
+	BIND_API(wake_up);
+	BIND_API(put_to_sleep);
+	BIND_API(debug_draw);
+	BIND_API(unit);
+	BIND_API(node);
+	BIND_API(set_collision_filter);
+	BIND_API(initial_shape_template);
+}
+
+} // end namespace
@@ -0,0 +1,174 @@
+#include "html5_api.h"
+#include "html5_api_bindings.h"
+
+#include <plugin_foundation/assert.h>
+
+#include <include/cef_task.h>
+
+#include <atomic>
+#include <deque>
+
+namespace PLUGIN_NAMESPACE {
+
+// Binding call made through `stingray.async`, waiting for the next frame boundary.
+struct AsyncApiCall
+{
+	CefRefPtr<CefV8Context> context;
+	CefRefPtr<CefV8Handler> handler;
+	CefString name;
+	CefV8ValueList arguments;
+	CefRefPtr<CefV8Value> resolve;
+	CefRefPtr<CefV8Value> reject;
+};
+
+// Calls are queued and run on the render thread, only pending_async_calls is read by the main thread.
+static std::deque<AsyncApiCall> async_calls;
+static std::atomic<unsigned> pending_async_calls(0);
+static unsigned async_batch_size = 64;
+
+// Keeps the resolve and reject functions a Promise passes to its executor.
+class PromiseExecutor : public CefV8Handler
+{
+public:
+	bool Execute(const CefString&, CefRefPtr<CefV8Value>, const CefV8ValueList& arguments, CefRefPtr<CefV8Value>&, CefString&) OVERRIDE
+	{
+		if (arguments.size() == 2) {
+			resolve = arguments[0];
+			reject = arguments[1];
+		}
+		return true;
+	}
+
+	CefRefPtr<CefV8Value> resolve;
+	CefRefPtr<CefV8Value> reject;
+	IMPLEMENT_REFCOUNTING(PromiseExecutor);
+};
+
+// Creates a Promise using `Reflect.construct`, since CEF can't call constructors.
+static CefRefPtr<CefV8Value> create_promise(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value>& resolve, CefRefPtr<CefV8Value>& reject)
+{
+	CefRefPtr<CefV8Value> global = context->GetGlobal();
+	CefRefPtr<CefV8Value> reflect = global->GetValue("Reflect");
+	CefRefPtr<PromiseExecutor> executor = new PromiseExecutor();
+
+	CefRefPtr<CefV8Value> promise_args = CefV8Value::CreateArray(1);
+	promise_args->SetValue(0, CefV8Value::CreateFunction("executor", executor.get()));
+
+	CefV8ValueList construct_args;
+	construct_args.push_back(global->GetValue("Promise"));
+	construct_args.push_back(promise_args);
+	CefRefPtr<CefV8Value> promise = reflect->GetValue("construct")->ExecuteFunction(reflect, construct_args);
+
+	resolve = executor->resolve;
+	reject = executor->reject;
+	return promise;
+}
+
+class AsyncApiHandler : public CefV8Handler
+{
+public:
+	explicit AsyncApiHandler(CefRefPtr<CefV8Handler> handler) : _handler(handler) {}
+
+	bool Execute(const CefString& name, CefRefPtr<CefV8Value>, const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& retval, CefString& exception) OVERRIDE
+	{
+		AsyncApiCall call;
+		call.context = CefV8Context::GetCurrentContext();
+		call.handler = _handler;
+		call.name = name;
+		call.arguments = arguments;
+
+		retval = create_promise(call.context, call.resolve, call.reject);
+		if (!retval || !call.resolve || !call.reject) {
+			exception = stingray::api::error->eprintf("Failed to create a promise for %s.", name.ToString().c_str());
+			return true;
+		}
+
+		async_calls.push_back(call);
+		pending_async_calls++;
+		return true;
+	}
+
+private:
+	CefRefPtr<CefV8Handler> _handler;
+	IMPLEMENT_REFCOUNTING(AsyncApiHandler);
+};
+
+CefRefPtr<CefV8Handler> create_async_handler(CefRefPtr<CefV8Handler> handler)
+{
+	return new AsyncApiHandler(handler);
+}
+
+static void run_async_api_call(const AsyncApiCall& call)
+{
+	call.context->Enter();
+
+	CefRefPtr<CefV8Value> retval;
+	CefString exception;
+	call.handler->Execute(call.name, nullptr, call.arguments, retval, exception);
+
+	CefV8ValueList settle_args;
+	if (exception.empty()) {
+		settle_args.push_back(retval ? retval : CefV8Value::CreateUndefined());
+		call.resolve->ExecuteFunction(nullptr, settle_args);
+	} else {
+		settle_args.push_back(CefV8Value::CreateString(exception));
+		call.reject->ExecuteFunction(nullptr, settle_args);
+	}
+
+	call.context->Exit();
+}
+
+// Runs a batch of queued calls on the render thread while the engine waits at its frame boundary.
+// The scope keeps the engine waiting until the batch is done. A task that starts after the engine
+// skipped its sync leaves the calls queued for the next frame, the scope would still grant direct
+// access to a page that isn't pipelined, so the batch checks the engine is held itself.
+class AsyncApiBatchTask : public CefTask
+{
+public:
+	void Execute() OVERRIDE
+	{
+		{
+			EngineApiScope scope;
+			for (unsigned i = 0; scope.engine_waiting && i < async_batch_size && !async_calls.empty(); ++i) {
+				XENSURE(scope.tracked && scope.access == API_ACCESS_DIRECT);
+				AsyncApiCall call = async_calls.front();
+				async_calls.pop_front();
+				pending_async_calls--;
+				run_async_api_call(call);
+			}
+		}
+		sync_signal();
+	}
+
+	IMPLEMENT_REFCOUNTING(AsyncApiBatchTask);
+};
+
+void flush_async_api_calls()
+{
+	if (pending_async_calls == 0)
+		return;
+
+	// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
+	SyncEngine sync;
+	if (!CefPostTask(TID_RENDERER, new AsyncApiBatchTask()))
+		sync_signal();
+}
+
+void set_async_api_batch_size(unsigned batch_size)
+{
+	async_batch_size = batch_size > 0 ? batch_size : 1;
+}
+
+void release_async_api_calls(CefRefPtr<CefV8Context> context)
+{
+	for (auto it = async_calls.begin(); it != async_calls.end();) {
+		if (it->context->IsSame(context)) {
+			it = async_calls.erase(it);
+			pending_async_calls--;
+		} else {
+			++it;
+		}
+	}
+}
+
+} // end namespace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stingray_api.h"
+#include "html5_api_profiler.h"
 
 #include <plugin_foundation/id_string.h>
 #include <plugin_foundation/matrix4x4.h>
@@ -9,7 +10,12 @@
 #include <include/cef_v8.h>
 #include <include/cef_base.h>
 
+#include <atomic>
 #include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace PLUGIN_NAMESPACE {
 
@@ -135,131 +141,149 @@ template<typename T_PTR> T_PTR get_ptr(CefRefPtr<CefV8Value> value)
 	return static_cast<T_PTR>(user_object->ptr());
 }
 
-// ReSharper disable once CppFunctionIsNotImplemented
-template<typename T> T get_arg(const CefV8ValueList& args, unsigned i);
+template<typename T> struct unsupported_arg : std::false_type {};
 
-template<typename T> T get_arg_struct(const CefV8ValueList& args, unsigned i)
+// Every type used by a bound function must have a decode_arg specialization. Since all bound
+// functions are instantiated by BIND_API, a missing one is reported when the plugin is compiled.
+// Arguments passed to decode_arg exist, the argument count is checked once by the caller.
+template<typename T> T decode_arg(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid() || !args[i]->IsUserCreated() || args[i]->IsNull() || args[i]->IsUndefined())
+	static_assert(unsupported_arg<T>::value, "No decode_arg specialization for this argument type");
+	return T();
+}
+
+// Value of a trailing argument the script did not pass, types without a default throw.
+template<typename T> T missing_arg()
+{
+	return T();
+}
+
+template<typename T> T missing_arg_error(const char* message)
+{
+	throw std::exception(message);
+}
+
+// Decodes argument `i` of a handler reading its own arguments, missing ones get their default value.
+template<typename T> T get_arg(const CefV8ValueList& args, unsigned i)
+{
+	return i < args.size() ? decode_arg<T>(args[i]) : missing_arg<T>();
+}
+
+template<typename T> T decode_arg_struct(const CefRefPtr<CefV8Value>& arg)
+{
+	if (!arg->IsUserCreated() || arg->IsNull() || arg->IsUndefined())
 		return nullptr;
-	return get_ptr<T>(args[i]);
+	return get_ptr<T>(arg);
 }
 
-template<typename E> E get_arg_enum(const CefV8ValueList& args, unsigned i)
+template<typename E> E decode_arg_enum(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return (E)0;
-	return (E)args[i]->GetIntValue();
+	return (E)arg->GetIntValue();
 }
 
-template<> inline VoidCallbackParamVoidPtr get_arg<VoidCallbackParamVoidPtr>(const CefV8ValueList& args, unsigned i)
+template<> inline VoidCallbackParamVoidPtr decode_arg<VoidCallbackParamVoidPtr>(const CefRefPtr<CefV8Value>& arg)
 {
 	// TODO:
 	return nullptr;
 }
 
-template<> inline char const * get_arg<char const *>(const CefV8ValueList& args, unsigned i)
+template<> inline char const * decode_arg<char const *>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || args[i]->IsNull() || args[i]->IsUndefined())
+	if (arg->IsNull() || arg->IsUndefined())
 		return nullptr;
-	if (!args[i]->IsString())
+	if (!arg->IsString())
 		throw std::exception("Argument must be a string");
 	CACHED_VALUE(std::string, str);
-	*str = args[i]->GetStringValue().ToString();
+	*str = arg->GetStringValue().ToString();
 	return (*str).c_str();
 }
 
-template<> inline unsigned int get_arg<unsigned int>(const CefV8ValueList& args, unsigned i)
+template<> inline unsigned int decode_arg<unsigned int>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return 0;
-	if (args[i]->IsString())
-		return IdString32(args[i]->GetStringValue().ToString().c_str()).id();
-	return args[i]->GetUIntValue();
+	if (arg->IsString())
+		return IdString32(arg->GetStringValue().ToString().c_str()).id();
+	return arg->GetUIntValue();
 }
 
-template<> inline int* get_arg<int*>(const CefV8ValueList& args, unsigned i)
+template<> inline int* decode_arg<int*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-
-	if (args[i]->IsUserCreated()) {
-		return get_arg_struct<int*>(args, i);
+	if (arg->IsUserCreated()) {
+		return decode_arg_struct<int*>(arg);
 	}
 
-	if (args[i]->IsUInt()) {
+	if (arg->IsUInt()) {
 		CACHED_VALUE(int, tv);
-		tv = args[i]->GetUIntValue();
+		tv = arg->GetUIntValue();
 		return &*tv;
 	}
 
 	return nullptr;
 }
 
-template<> inline unsigned int* get_arg<unsigned int*>(const CefV8ValueList& args, unsigned i)
+template<> inline unsigned int* decode_arg<unsigned int*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-
-	if (args[i]->IsUserCreated()) {
-		return get_arg_struct<unsigned int*>(args, i);
+	if (arg->IsUserCreated()) {
+		return decode_arg_struct<unsigned int*>(arg);
 	}
 
-	if (args[i]->IsUInt()) {
+	if (arg->IsUInt()) {
 		CACHED_VALUE(unsigned, tv);
-		tv = args[i]->GetUIntValue();
+		tv = arg->GetUIntValue();
 		return &*tv;
 	}
 
 	return nullptr;
 }
 
-template<> inline int get_arg<int>(const CefV8ValueList& args, unsigned i)
+template<> inline int decode_arg<int>(const CefRefPtr<CefV8Value>& arg)
+{
+	if (arg->IsBool())
+		return arg->GetBoolValue() ? 1 : 0;
+	return arg->GetIntValue();
+}
+
+template<> inline float decode_arg<float>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return 0;
-	if (args[i]->IsBool())
-		return args[i]->GetBoolValue() ? 1 : 0;
-	return args[i]->GetIntValue();
+	return (float)arg->GetDoubleValue();
 }
 
-template<> inline float get_arg<float>(const CefV8ValueList& args, unsigned i)
+template<> inline float missing_arg<float>()
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return std::numeric_limits<float>::infinity();
-	return (float)args[i]->GetDoubleValue();
+	return std::numeric_limits<float>::infinity();
 }
 
-template<> inline uint64_t get_arg<uint64_t>(const CefV8ValueList& args, unsigned i)
+template<> inline uint64_t decode_arg<uint64_t>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return 0;
-	if (args[i]->IsString())
-		return IdString64(args[i]->GetStringValue().ToString().c_str()).id();
-	if (args[i]->IsDouble())
-		return (uint64_t)args[i]->GetDoubleValue();
-	if (args[i]->IsUserCreated())
-		return static_cast<UserObject*>(args[i]->GetUserData().get())->id();
+	if (arg->IsString())
+		return IdString64(arg->GetStringValue().ToString().c_str()).id();
+	if (arg->IsDouble())
+		return (uint64_t)arg->GetDoubleValue();
+	if (arg->IsUserCreated())
+		return static_cast<UserObject*>(arg->GetUserData().get())->id();
 	return 0;
 }
 
-template<> inline WindowRectWrapper get_arg<WindowRectWrapper>(const CefV8ValueList& args, unsigned i)
+template<> inline WindowRectWrapper decode_arg<WindowRectWrapper>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid() || !args[i]->IsArray() || args[i]->GetArrayLength() != 4)
+	if (!arg->IsArray() || arg->GetArrayLength() != 4)
 		throw std::exception("Argument is not a rect");
 	WindowRectWrapper rect;
 	for (int pi = 0; pi < 4; ++pi) {
-		rect.pos[pi] = args[pi]->GetValue(0)->GetIntValue();
+		rect.pos[pi] = arg->GetValue(pi)->GetIntValue();
 	}
 	return rect;
 }
 
-template<> inline WindowOpenParameter* get_arg<WindowOpenParameter*>(const CefV8ValueList& args, unsigned i)
+template<> inline WindowRectWrapper missing_arg<WindowRectWrapper>()
 {
-	if (i >= args.size() || !args[i]->IsValid() || !args[i]->IsObject())
+	return missing_arg_error<WindowRectWrapper>("Argument is not a rect");
+}
+
+template<> inline WindowOpenParameter* decode_arg<WindowOpenParameter*>(const CefRefPtr<CefV8Value>& arg)
+{
+	if (!arg->IsObject())
 		throw std::exception("Argument is a window open parameters object");
 
-	auto arg = args[i];
 	CACHED_VALUE(WindowOpenParameter, cv);
 	WindowOpenParameter& open_params = *cv;
 	if (arg->HasValue( "x" )) open_params.x = arg->GetValue( "x" )->GetIntValue();;
@@ -280,106 +304,121 @@ template<> inline WindowOpenParameter* get_arg<WindowOpenParameter*>(const CefV8
 	return &open_params;
 }
 
-template<> inline const CApiVector2* get_arg<const CApiVector2*>(const CefV8ValueList& args, unsigned i)
+template<> inline WindowOpenParameter* missing_arg<WindowOpenParameter*>()
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-	if (args[i]->IsArray() && args[i]->GetArrayLength() == 2) {
+	return missing_arg_error<WindowOpenParameter*>("Argument is a window open parameters object");
+}
+
+template<> inline const CApiVector2* decode_arg<const CApiVector2*>(const CefRefPtr<CefV8Value>& arg)
+{
+	if (arg->IsArray() && arg->GetArrayLength() == 2) {
 		CACHED_VALUE(CApiVector2, tv);
-		(*tv).x = (float)args[i]->GetValue(0)->GetDoubleValue();
-		(*tv).y = (float)args[i]->GetValue(1)->GetDoubleValue();
+		(*tv).x = (float)arg->GetValue(0)->GetDoubleValue();
+		(*tv).y = (float)arg->GetValue(1)->GetDoubleValue();
 		return &*tv;
 	}
 	return nullptr;
 }
 
-template<> inline CApiVector2 get_arg<CApiVector2>(const CefV8ValueList& args, unsigned i)
+template<typename T> T decode_arg_value(const CefRefPtr<CefV8Value>& arg)
 {
-	return *get_arg<const CApiVector2*>(args, i);
+	const T* value = decode_arg<const T*>(arg);
+	if (!value)
+		throw std::exception("Argument is not a vector");
+	return *value;
 }
 
-template<> inline const CApiVector3* get_arg<const CApiVector3*>(const CefV8ValueList& args, unsigned i)
+template<> inline CApiVector2 decode_arg<CApiVector2>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-	if (args[i]->IsArray() && args[i]->GetArrayLength() == 3) {
+	return decode_arg_value<CApiVector2>(arg);
+}
+
+template<> inline const CApiVector3* decode_arg<const CApiVector3*>(const CefRefPtr<CefV8Value>& arg)
+{
+	if (arg->IsArray() && arg->GetArrayLength() == 3) {
 		CACHED_VALUE(CApiVector3, tv);
-		(*tv).x = (float)args[i]->GetValue(0)->GetDoubleValue();
-		(*tv).y = (float)args[i]->GetValue(1)->GetDoubleValue();
-		(*tv).z = (float)args[i]->GetValue(2)->GetDoubleValue();
+		(*tv).x = (float)arg->GetValue(0)->GetDoubleValue();
+		(*tv).y = (float)arg->GetValue(1)->GetDoubleValue();
+		(*tv).z = (float)arg->GetValue(2)->GetDoubleValue();
 		return &*tv;
 	}
 	return nullptr;
 }
 
-template<> inline CApiVector3 get_arg<CApiVector3>(const CefV8ValueList& args, unsigned i)
+template<> inline CApiVector3 decode_arg<CApiVector3>(const CefRefPtr<CefV8Value>& arg)
 {
-	return *get_arg<const CApiVector3*>(args, i);
+	return decode_arg_value<CApiVector3>(arg);
 }
 
-template<> inline const CApiVector4* get_arg<const CApiVector4*>(const CefV8ValueList& args, unsigned i)
+template<> inline const CApiVector4* decode_arg<const CApiVector4*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-	if (args[i]->IsArray() && args[i]->GetArrayLength() == 4) {
+	if (arg->IsArray() && arg->GetArrayLength() == 4) {
 		CACHED_VALUE(CApiVector4, tv);
-		(*tv).x = (float)args[i]->GetValue(0)->GetDoubleValue();
-		(*tv).y = (float)args[i]->GetValue(1)->GetDoubleValue();
-		(*tv).z = (float)args[i]->GetValue(2)->GetDoubleValue();
-		(*tv).w = (float)args[i]->GetValue(3)->GetDoubleValue();
+		(*tv).x = (float)arg->GetValue(0)->GetDoubleValue();
+		(*tv).y = (float)arg->GetValue(1)->GetDoubleValue();
+		(*tv).z = (float)arg->GetValue(2)->GetDoubleValue();
+		(*tv).w = (float)arg->GetValue(3)->GetDoubleValue();
 		return &*tv;
 	}
 	return nullptr;
 }
 
-template<> inline CApiVector4 get_arg<CApiVector4>(const CefV8ValueList& args, unsigned i)
+template<> inline CApiVector4 decode_arg<CApiVector4>(const CefRefPtr<CefV8Value>& arg)
 {
-	return *get_arg<const CApiVector4*>(args, i);
+	return decode_arg_value<CApiVector4>(arg);
 }
 
-template<> inline const CApiQuaternion* get_arg<const CApiQuaternion*>(const CefV8ValueList& args, unsigned i)
+template<> inline const CApiQuaternion* decode_arg<const CApiQuaternion*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (i >= args.size() || !args[i]->IsValid())
-		return nullptr;
-	if (args[i]->IsArray() && args[i]->GetArrayLength() == 4) {
+	if (arg->IsArray() && arg->GetArrayLength() == 4) {
 		CACHED_VALUE(CApiQuaternion, tv);
-		(*tv).x = (float)args[i]->GetValue(0)->GetDoubleValue();
-		(*tv).y = (float)args[i]->GetValue(1)->GetDoubleValue();
-		(*tv).z = (float)args[i]->GetValue(2)->GetDoubleValue();
-		(*tv).w = (float)args[i]->GetValue(3)->GetDoubleValue();
+		(*tv).x = (float)arg->GetValue(0)->GetDoubleValue();
+		(*tv).y = (float)arg->GetValue(1)->GetDoubleValue();
+		(*tv).z = (float)arg->GetValue(2)->GetDoubleValue();
+		(*tv).w = (float)arg->GetValue(3)->GetDoubleValue();
 		return &*tv;
 	}
 	return nullptr;
 }
 
-template<> inline CApiQuaternion get_arg<CApiQuaternion>(const CefV8ValueList& args, unsigned i)
+template<> inline CApiQuaternion decode_arg<CApiQuaternion>(const CefRefPtr<CefV8Value>& arg)
 {
-	return *get_arg<const CApiQuaternion*>(args, i);
+	return decode_arg_value<CApiQuaternion>(arg);
 }
 
-template<> inline const Matrix4x4* get_arg<const Matrix4x4*>(const CefV8ValueList& args, unsigned arg_index)
+template<> inline CApiVector2 missing_arg<CApiVector2>() { return missing_arg_error<CApiVector2>("Argument is not a vector"); }
+template<> inline CApiVector3 missing_arg<CApiVector3>() { return missing_arg_error<CApiVector3>("Argument is not a vector"); }
+template<> inline CApiVector4 missing_arg<CApiVector4>() { return missing_arg_error<CApiVector4>("Argument is not a vector"); }
+template<> inline CApiQuaternion missing_arg<CApiQuaternion>() { return missing_arg_error<CApiQuaternion>("Argument is not a vector"); }
+
+template<> inline const Matrix4x4* decode_arg<const Matrix4x4*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (arg_index >= args.size() || !args[arg_index]->IsValid())
-		throw std::exception("Argument must be a matrix");
 	CACHED_VALUE(Matrix4x4, m);
-	if (args[arg_index]->IsArray() && args[arg_index]->GetArrayLength() == 16) {
+	if (arg->IsArray() && arg->GetArrayLength() == 16) {
 		for (unsigned i = 0; i < 16; ++i)
-			(*m).v[i] = args[arg_index]->GetValue(i)->GetDoubleValue();
+			(*m).v[i] = arg->GetValue(i)->GetDoubleValue();
 		return &*m;
 	}
 	throw std::exception("Cannot get matrix 4x4 from argument");
 }
 
-template<> inline Matrix4x4 get_arg<Matrix4x4>(const CefV8ValueList& args, unsigned arg_index)
+template<> inline const Matrix4x4* missing_arg<const Matrix4x4*>()
+{
+	return missing_arg_error<const Matrix4x4*>("Argument must be a matrix");
+}
+
+template<> inline Matrix4x4 decode_arg<Matrix4x4>(const CefRefPtr<CefV8Value>& arg)
 {
-	return *get_arg<const Matrix4x4*>(args, arg_index);
+	return *decode_arg<const Matrix4x4*>(arg);
 }
 
-template<> inline DynamicScriptDataItem get_arg<DynamicScriptDataItem>(const CefV8ValueList& args, unsigned index)
+template<> inline Matrix4x4 missing_arg<Matrix4x4>()
+{
+	return missing_arg_error<Matrix4x4>("Argument must be a matrix");
+}
+
+template<> inline DynamicScriptDataItem decode_arg<DynamicScriptDataItem>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (index >= args.size() || !args[index]->IsValid())
-		throw std::exception("Argument not of type DynamicScriptDataItem");
-	const auto& arg = args[index];
 	DynamicScriptDataItem result = { nullptr };
 
 	if (arg->IsNull() || arg->IsUndefined()) {
@@ -446,38 +485,43 @@ template<> inline DynamicScriptDataItem get_arg<DynamicScriptDataItem>(const Cef
 	return result;
 }
 
-template<> inline DeadZoneSetting* get_arg<DeadZoneSetting*>(const CefV8ValueList& args, unsigned arg_index)
+template<> inline DynamicScriptDataItem missing_arg<DynamicScriptDataItem>()
 {
-	if (arg_index >= args.size() || !args[arg_index]->IsObject() || args[arg_index]->IsUndefined() || args[arg_index]->IsNull())
+	return missing_arg_error<DynamicScriptDataItem>("Argument not of type DynamicScriptDataItem");
+}
+
+template<> inline DeadZoneSetting* decode_arg<DeadZoneSetting*>(const CefRefPtr<CefV8Value>& arg)
+{
+	if (!arg->IsObject() || arg->IsUndefined() || arg->IsNull())
 		return nullptr;
 	CACHED_VALUE(DeadZoneSetting, dzs);
-	(*dzs).mode = (DeadZoneMode)args[arg_index]->GetValue("mode")->GetIntValue();
-	(*dzs).size = args[arg_index]->GetValue("size")->GetDoubleValue();
+	(*dzs).mode = (DeadZoneMode)arg->GetValue("mode")->GetIntValue();
+	(*dzs).size = arg->GetValue("size")->GetDoubleValue();
 	return &*dzs;
 }
 
-template<> inline RumbleParameters* get_arg<RumbleParameters*>(const CefV8ValueList& args, unsigned arg_index)
+template<> inline RumbleParameters* decode_arg<RumbleParameters*>(const CefRefPtr<CefV8Value>& arg)
 {
-	if (arg_index >= args.size() || !args[arg_index]->IsObject() || args[arg_index]->IsUndefined() || args[arg_index]->IsNull())
+	if (!arg->IsObject() || arg->IsUndefined() || arg->IsNull())
 		return nullptr;
 	CACHED_VALUE(RumbleParameters, params);
-	(*params).frequency = args[arg_index]->GetValue("frequency")->GetDoubleValue();
-	(*params).offset = args[arg_index]->GetValue("offset")->GetDoubleValue();
-	(*params).attack_level = args[arg_index]->GetValue("attack_level")->GetDoubleValue();
-	(*params).sustain_level = args[arg_index]->GetValue("sustain_level")->GetDoubleValue();
-	(*params).attack = args[arg_index]->GetValue("attack")->GetDoubleValue();
-	(*params).release = args[arg_index]->GetValue("release")->GetDoubleValue();
-	(*params).sustain = args[arg_index]->GetValue("sustain")->GetDoubleValue();
-	(*params).decay = args[arg_index]->GetValue("decay")->GetDoubleValue();
+	(*params).frequency = arg->GetValue("frequency")->GetDoubleValue();
+	(*params).offset = arg->GetValue("offset")->GetDoubleValue();
+	(*params).attack_level = arg->GetValue("attack_level")->GetDoubleValue();
+	(*params).sustain_level = arg->GetValue("sustain_level")->GetDoubleValue();
+	(*params).attack = arg->GetValue("attack")->GetDoubleValue();
+	(*params).release = arg->GetValue("release")->GetDoubleValue();
+	(*params).sustain = arg->GetValue("sustain")->GetDoubleValue();
+	(*params).decay = arg->GetValue("decay")->GetDoubleValue();
 	return &*params;
 }
 
 #define DEFINE_GET_ARG_STRUCT(__T) \
-	template<> inline __T get_arg<__T>(const CefV8ValueList& args, unsigned i) { return get_arg_struct<__T>(args, i); } \
-	template<> inline const __T get_arg<const __T>(const CefV8ValueList& args, unsigned i) { return get_arg_struct<const __T>(args, i); }
+	template<> inline __T decode_arg<__T>(const CefRefPtr<CefV8Value>& arg) { return decode_arg_struct<__T>(arg); } \
+	template<> inline const __T decode_arg<const __T>(const CefRefPtr<CefV8Value>& arg) { return decode_arg_struct<const __T>(arg); }
 
 #define DEFINE_GET_ARG_ENUM(__E) \
-	template<> inline __E get_arg<__E>(const CefV8ValueList& args, unsigned i) { return get_arg_enum<__E>(args, i); }
+	template<> inline __E decode_arg<__E>(const CefRefPtr<CefV8Value>& arg) { return decode_arg_enum<__E>(arg); }
 
 DEFINE_GET_ARG_STRUCT(void *)
 DEFINE_GET_ARG_STRUCT(DynamicScriptDataItem *)
@@ -502,6 +546,9 @@ DEFINE_GET_ARG_STRUCT(CApiVideoPlayer *)
 DEFINE_GET_ARG_STRUCT(CApiReplay *)
 DEFINE_GET_ARG_STRUCT(TimeStepPolicyWrapper *)
 DEFINE_GET_ARG_STRUCT(MultipleStringsBuffer *)
+DEFINE_GET_ARG_STRUCT(CApiMesh *)
+DEFINE_GET_ARG_STRUCT(CApiLineObject *)
+DEFINE_GET_ARG_STRUCT(CApiPhysicsWorld *)
 
 DEFINE_GET_ARG_STRUCT(CApiLocalTransform *)
 
@@ -513,6 +560,9 @@ DEFINE_GET_ARG_ENUM(TimeStepPolicyType)
 DEFINE_GET_ARG_ENUM(CameraProjectionType)
 DEFINE_GET_ARG_ENUM(CameraMode)
 DEFINE_GET_ARG_ENUM(WindowKeystrokes)
+DEFINE_GET_ARG_ENUM(RaycastType)
+DEFINE_GET_ARG_ENUM(ActorTemplate)
+DEFINE_GET_ARG_ENUM(OverlapShape)
 
 // WRAP RESULT
 
@@ -633,6 +683,28 @@ inline void wrap_result(const MoverFitsAtResult& mfat, CefRefPtr<CefV8Value>& re
 	retval->SetValue("fits", CefV8Value::CreateInt(mfat.fits), V8_PROPERTY_ATTRIBUTE_READONLY);
 	retval->SetValue("pos", pos, V8_PROPERTY_ATTRIBUTE_READONLY);
 }
+inline void wrap_result(const MoverSeparateResult& msr, CefRefPtr<CefV8Value>& retval)
+{
+	retval = CefV8Value::CreateObject(nullptr, nullptr);
+	CefRefPtr<CefV8Value> pos;
+	wrap_result(msr.position_after_resolving, pos);
+
+	retval->SetValue("is_colliding", CefV8Value::CreateBool(msr.is_colliding != 0), V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("can_be_resolved", CefV8Value::CreateBool(msr.can_be_resolved != 0), V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("position_after_resolving", pos, V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("collides_with", msr.collides_with ? UserObject::CreateObjectPtr(msr.collides_with) : CefV8Value::CreateNull(), V8_PROPERTY_ATTRIBUTE_READONLY);
+}
+inline void wrap_result(const BoundingVolumeWrapper& bvw, CefRefPtr<CefV8Value>& retval)
+{
+	retval = CefV8Value::CreateObject(nullptr, nullptr);
+	CefRefPtr<CefV8Value> min, max;
+	wrap_result(bvw.min, min);
+	wrap_result(bvw.max, max);
+
+	retval->SetValue("min", min, V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("max", max, V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("radius", CefV8Value::CreateDouble(bvw.radius), V8_PROPERTY_ATTRIBUTE_READONLY);
+}
 inline void wrap_result(const BoneNamesWrapper& names, CefRefPtr<CefV8Value>& retval)
 {
 	retval = CefV8Value::CreateArray(names.num_bones);
@@ -771,6 +843,18 @@ inline CefRefPtr<CefV8Value> wrap_result(const Vector3ArrayWrapper& v3aw, CefRef
 	}
 	return retval;
 }
+inline void wrap_result(const CollisionHit& hit, CefRefPtr<CefV8Value>& retval)
+{
+	retval = CefV8Value::CreateObject(nullptr, nullptr);
+	CefRefPtr<CefV8Value> position, normal;
+	wrap_result(hit.position, position);
+	wrap_result(hit.normal, normal);
+
+	retval->SetValue("position", position, V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("normal", normal, V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("distance", CefV8Value::CreateDouble(hit.distance), V8_PROPERTY_ATTRIBUTE_READONLY);
+	retval->SetValue("actor", hit.actor ? UserObject::CreateObjectPtr(hit.actor) : CefV8Value::CreateNull(), V8_PROPERTY_ATTRIBUTE_READONLY);
+}
 inline CefRefPtr<CefV8Value> wrap_result(const DeadZoneSetting& dzs, CefRefPtr<CefV8Value>& retval)
 {
 	retval = CefV8Value::CreateObject(nullptr, nullptr);
@@ -779,101 +863,187 @@ inline CefRefPtr<CefV8Value> wrap_result(const DeadZoneSetting& dzs, CefRefPtr<C
 	return retval;
 }
 
-// Return void
+// ENGINE ACCESS
+//
+// Pages may only call the engine directly while the engine thread waits for them, see wait_for_sync().
+// Outside of it, pipelined pages run while the engine carries on with its frame. Bound functions
+// without result are then queued and applied on the main thread at the next sync point. Their
+// decoded arguments are copied, since pointers might refer to cached values. Functions returning a
+// value or having out parameters throw, the page reads engine state through `stingray.async` instead.
 
-inline void call_f(void(*f)(), const CefV8ValueList&, CefRefPtr<CefV8Value>&) {
-	f();
-}
-template<typename P0>
-void call_f(void(*f)(P0), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0));
-}
-template<typename P0, typename P1>
-void call_f(void(*f)(P0, P1), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1));
-}
-template<typename P0, typename P1, typename P2>
-void call_f(void(*f)(P0, P1, P2), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2));
-}
-template<typename P0, typename P1, typename P2, typename P3>
-void call_f(void(*f)(P0,P1,P2,P3), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3));
-}
-template<typename P0, typename P1, typename P2, typename P3, typename P4>
-void call_f(void(*f)(P0,P1,P2,P3,P4), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3), get_arg<P4>(args, 4));
-}
-template<typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
-void call_f(void(*f)(P0,P1,P2,P3,P4,P5), const CefV8ValueList& args, CefRefPtr<CefV8Value>&) {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5));
-}
-template<typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-void call_f(void(*f)(P0, P1, P2, P3, P4, P5, P6), const CefV8ValueList& args, CefRefPtr<CefV8Value>&)
+enum ApiAccess
 {
-	f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5), get_arg<P6>(args, 6));
-}
+	API_ACCESS_DIRECT,	// The engine waits, the call runs immediately.
+	API_ACCESS_DEFERRED	// The engine runs its frame, writes are queued and reads refused.
+};
 
-// Return result
+// Access of the binding call executing on this thread.
+extern thread_local ApiAccess current_api_access;
 
-template<typename R>
-void call_f(R(*f)(), const CefV8ValueList&, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(), retval);
-}
-template<typename R, typename P0>
-void call_f(R(*f)(P0), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(get_arg<P0>(args, 0)), retval);
-}
-template<typename R, typename P0, typename P1>
-void call_f(R(*f)(P0,P1), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(get_arg<P0>(args, 0), get_arg<P1>(args, 1)), retval);
-}
-template<typename R, typename P0, typename P1, typename P2>
-void call_f(R(*f)(P0,P1,P2), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2)), retval);
-}
-template<typename R, typename P0, typename P1, typename P2, typename P3>
-void call_f(R(*f)(P0,P1,P2,P3), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3)), retval);
-}
-template<typename R, typename P0, typename P1, typename P2, typename P3, typename P4>
-void call_f(R(*f)(P0,P1,P2,P3,P4), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2), get_arg<P3>(args, 3), get_arg<P4>(args, 4)), retval);
+// Decides the access of a binding call, the engine doesn't leave its wait while a direct call runs.
+// Calls of pages that aren't pipelined stay direct when the engine isn't waiting, engine_waiting
+// tells whether the engine is actually held.
+struct EngineApiScope
+{
+	EngineApiScope();
+	~EngineApiScope();
+
+	ApiAccess access;
+	ApiAccess previous_access;
+	bool engine_waiting;
+	bool tracked;
+};
+
+#define ENGINE_BUSY_ERROR "the engine is running its frame, use stingray.async to read engine state"
+
+void queue_api_write(std::function<void()> write);
+
+template<typename T> struct deferred_arg
+{
+	static const bool supported = std::is_arithmetic<T>::value || std::is_enum<T>::value;
+	typedef T storage;
+	static storage store(T v) { return v; }
+	static T load(const storage& v) { return v; }
+};
+
+template<> struct deferred_arg<const char*>
+{
+	static const bool supported = true;
+	typedef std::pair<bool, std::string> storage;
+	static storage store(const char* v) { return v ? storage(true, v) : storage(false, std::string()); }
+	static const char* load(const storage& v) { return v.first ? v.second.c_str() : nullptr; }
+};
+
+template<typename T> struct deferred_object_arg
+{
+	static const bool supported = true;
+	typedef T storage;
+	static storage store(T v) { return v; }
+	static T load(const storage& v) { return v; }
+};
+
+template<typename T> struct deferred_value_arg : deferred_object_arg<T> {};
+
+template<typename T> struct deferred_value_arg<const T*>
+{
+	static const bool supported = true;
+	typedef std::pair<bool, T> storage;
+	static storage store(const T* v) { return v ? storage(true, *v) : storage(false, T()); }
+	static const T* load(const storage& v) { return v.first ? &v.second : nullptr; }
+};
+
+// Engine objects are passed as is, others need their value to be copied.
+#define DEFINE_DEFERRED_ARG_OBJECT(__T) \
+	template<> struct deferred_arg<__T> : deferred_object_arg<__T> {}; \
+	template<> struct deferred_arg<const __T> : deferred_object_arg<const __T> {};
+#define DEFINE_DEFERRED_ARG_VALUE(__T) \
+	template<> struct deferred_arg<__T> : deferred_value_arg<__T> {}; \
+	template<> struct deferred_arg<const __T*> : deferred_value_arg<const __T*> {};
+
+DEFINE_DEFERRED_ARG_OBJECT(CApiWorld *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiShadingEnvironment *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiLevel *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiViewport *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiCamera *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiWindow *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiMover *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiMaterial *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiActor *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiLight *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiGui *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiVideoPlayer *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiMesh *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiLineObject *)
+DEFINE_DEFERRED_ARG_OBJECT(CApiPhysicsWorld *)
+
+DEFINE_DEFERRED_ARG_VALUE(CApiVector2)
+DEFINE_DEFERRED_ARG_VALUE(CApiVector3)
+DEFINE_DEFERRED_ARG_VALUE(CApiVector4)
+DEFINE_DEFERRED_ARG_VALUE(CApiQuaternion)
+DEFINE_DEFERRED_ARG_VALUE(CApiMatrix4x4)
+
+template<bool...> struct bool_pack;
+template<typename... P> struct deferrable_args
+	: std::is_same<bool_pack<true, deferred_arg<P>::supported...>, bool_pack<deferred_arg<P>::supported..., true>> {};
+
+template<typename... P, size_t... I>
+bool defer_f(std::true_type, void(*f)(P...), const std::tuple<P...>& decoded, std::index_sequence<I...>)
+{
+	std::tuple<typename deferred_arg<P>::storage...> stored{ deferred_arg<P>::store(std::get<I>(decoded))... };
+	queue_api_write([f, stored]() { f(deferred_arg<P>::load(std::get<I>(stored))...); });
+	return true;
 }
-template<typename R, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5>
-void call_f(R(*f)(P0,P1,P2,P3,P4,P5), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval) {
-	wrap_result(f(
-		get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2),
-		get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5)), retval);
+
+template<typename... P, size_t... I>
+bool defer_f(std::false_type, void(*)(P...), const std::tuple<P...>&, std::index_sequence<I...>)
+{
+	return false;
 }
-template<typename R, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6>
-void call_f(R(*f)(P0, P1, P2, P3, P4, P5, P6), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval)
+
+// CALL FUNCTION
+//
+// Arguments are decoded into a tuple using a braced initializer list, which guarantees a left to
+// right evaluation order, then forwarded to the C-API function. Each bound signature gets its own
+// instantiation, so the whole call inlines to straight-line code.
+//
+// The argument count is checked once. When the script passed every argument they are decoded
+// without bounds checks, otherwise missing trailing ones get their default value from get_arg.
+
+template<typename P> P decode_arg_at(std::true_type, const CefV8ValueList& args, unsigned i) { return decode_arg<P>(args[i]); }
+template<typename P> P decode_arg_at(std::false_type, const CefV8ValueList& args, unsigned i) { return get_arg<P>(args, i); }
+
+template<typename... P, typename C, size_t... I>
+std::tuple<P...> decode_args(C complete, const CefV8ValueList& args, std::index_sequence<I...>)
 {
-	wrap_result(f(
-		get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2),
-		get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5),
-		get_arg<P6>(args, 6)), retval);
+	return std::tuple<P...>{ decode_arg_at<P>(complete, args, I)... };
 }
-template<typename R, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7>
-void call_f(R(*f)(P0, P1, P2, P3, P4, P5, P6, P7), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval)
+
+template<typename... P, size_t... I>
+std::tuple<P...> decode_args(const CefV8ValueList& args, std::index_sequence<I...> indexes)
 {
-	wrap_result(f(
-		get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2),
-		get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5),
-		get_arg<P6>(args, 6), get_arg<P7>(args, 7)), retval);
+	if (args.size() >= sizeof...(P))
+		return decode_args<P...>(std::true_type(), args, indexes);
+	return decode_args<P...>(std::false_type(), args, indexes);
 }
-template<typename R, typename P0, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8>
-void call_f(R(*f)(P0, P1, P2, P3, P4, P5, P6, P7, P8), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval)
+
+template<typename... P, size_t... I>
+uint64_t invoke_f(void(*f)(P...), const CefV8ValueList& args, CefRefPtr<CefV8Value>&, std::index_sequence<I...>)
 {
-	wrap_result(f(
-		get_arg<P0>(args, 0), get_arg<P1>(args, 1), get_arg<P2>(args, 2),
-		get_arg<P3>(args, 3), get_arg<P4>(args, 4), get_arg<P5>(args, 5),
-		get_arg<P6>(args, 6), get_arg<P7>(args, 7), get_arg<P8>(args, 8)), retval);
+	const uint64_t decode_start_ticks = api_profiler_ticks();
+	std::tuple<P...> decoded = decode_args<P...>(args, std::index_sequence<I...>());
+	const uint64_t decode_ticks = decode_start_ticks != 0 ? api_profiler_ticks() - decode_start_ticks : 0;
+	if (current_api_access == API_ACCESS_DIRECT)
+		f(std::get<I>(decoded)...);
+	else if (!defer_f(deferrable_args<P...>(), f, decoded, std::index_sequence<I...>()))
+		throw std::exception(ENGINE_BUSY_ERROR);
+	return decode_ticks;
+}
+
+template<typename R, typename... P, size_t... I>
+uint64_t invoke_f(R(*f)(P...), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval, std::index_sequence<I...>)
+{
+	const uint64_t decode_start_ticks = api_profiler_ticks();
+	std::tuple<P...> decoded = decode_args<P...>(args, std::index_sequence<I...>());
+	const uint64_t decode_ticks = decode_start_ticks != 0 ? api_profiler_ticks() - decode_start_ticks : 0;
+	if (current_api_access != API_ACCESS_DIRECT)
+		throw std::exception(ENGINE_BUSY_ERROR);
+	wrap_result(f(std::get<I>(decoded)...), retval);
+	return decode_ticks;
+}
+
+// Returns the ticks spent decoding arguments when the binding profiler is enabled.
+template<typename R, typename... P>
+uint64_t call_f(R(*f)(P...), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval)
+{
+	// Extra arguments are ignored.
+	return invoke_f(f, args, retval, std::index_sequence_for<P...>());
 }
 
 // Used to process C-API that returns a list of items.
-template<typename R> void call_f(R(*f)(unsigned*), const CefV8ValueList&, CefRefPtr<CefV8Value>& retval)
+template<typename R> uint64_t call_f(R(*f)(unsigned*), const CefV8ValueList&, CefRefPtr<CefV8Value>& retval)
 {
+	if (current_api_access != API_ACCESS_DIRECT)
+		throw std::exception(ENGINE_BUSY_ERROR);
 	unsigned n = 0;
 	R items = f(&n);
 	retval = CefV8Value::CreateArray(n);
@@ -882,6 +1052,72 @@ template<typename R> void call_f(R(*f)(unsigned*), const CefV8ValueList&, CefRef
 		wrap_result(items[i], wrapped_item);
 		retval->SetValue(i, wrapped_item);
 	}
+	return 0;
+}
+
+// OUT BUFFERS
+//
+// Functions filling a caller provided array, i.e. `unsigned raycast(CollisionHit* out_buffer, unsigned num_elements, ...)`,
+// are bound without the buffer and its size. They fill a thread local buffer and the handler returns its items as an array.
+
+static const unsigned MAX_OUT_BUFFER_ITEMS = 64;
+
+template<size_t K, typename F> struct OutBufferFunction { F f; };
+
+template<size_t K, typename F> OutBufferFunction<K, F> out_buffer_function(F f) { return { f }; }
+
+typedef std::integral_constant<int, 0> out_buffer_script_arg;
+typedef std::integral_constant<int, 1> out_buffer_items_arg;
+typedef std::integral_constant<int, 2> out_buffer_size_arg;
+
+// Script argument index of native argument `i`, the buffer and its size at `k` and `k + 1` have none.
+constexpr unsigned out_buffer_script_index(size_t k, size_t i) { return (unsigned)(i < k ? i : i >= k + 2 ? i - 2 : 0); }
+
+template<size_t K, size_t I> using out_buffer_arg_kind = std::integral_constant<int, I == K ? 1 : I == K + 1 ? 2 : 0>;
+
+template<typename P, typename C, typename T> P get_out_buffer_arg(out_buffer_script_arg, C complete, const CefV8ValueList& args, unsigned i, T*) { return decode_arg_at<P>(complete, args, i); }
+template<typename P, typename C, typename T> P get_out_buffer_arg(out_buffer_items_arg, C, const CefV8ValueList&, unsigned, T* items) { return items; }
+template<typename P, typename C, typename T> P get_out_buffer_arg(out_buffer_size_arg, C, const CefV8ValueList&, unsigned, T*) { return MAX_OUT_BUFFER_ITEMS; }
+
+template<size_t K, typename... P, typename C, typename T, size_t... I>
+std::tuple<P...> decode_out_buffer_args(C complete, const CefV8ValueList& args, T* items, std::index_sequence<I...>)
+{
+	// Script arguments after the buffer are shifted by the two native ones.
+	return std::tuple<P...>{ get_out_buffer_arg<P>(out_buffer_arg_kind<K, I>(), complete, args, out_buffer_script_index(K, I), items)... };
+}
+
+template<size_t K, typename... P, size_t... I>
+uint64_t invoke_out_buffer_f(unsigned(*f)(P...), const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval, std::index_sequence<I...>)
+{
+	typedef typename std::remove_pointer<typename std::tuple_element<K, std::tuple<P...>>::type>::type T;
+	static thread_local T items[MAX_OUT_BUFFER_ITEMS];
+
+	const uint64_t decode_start_ticks = api_profiler_ticks();
+	std::tuple<P...> decoded = args.size() + 2 >= sizeof...(P)
+		? decode_out_buffer_args<K, P...>(std::true_type(), args, items, std::index_sequence<I...>())
+		: decode_out_buffer_args<K, P...>(std::false_type(), args, items, std::index_sequence<I...>());
+	const uint64_t decode_ticks = decode_start_ticks != 0 ? api_profiler_ticks() - decode_start_ticks : 0;
+
+	if (current_api_access != API_ACCESS_DIRECT)
+		throw std::exception(ENGINE_BUSY_ERROR);
+
+	// The result is the total number of items, only the first ones fit in the buffer.
+	unsigned n = f(std::get<I>(decoded)...);
+	if (n > MAX_OUT_BUFFER_ITEMS)
+		n = MAX_OUT_BUFFER_ITEMS;
+	retval = CefV8Value::CreateArray(n);
+	for (unsigned i = 0; i < n; ++i) {
+		CefRefPtr<CefV8Value> wrapped_item;
+		wrap_result(items[i], wrapped_item);
+		retval->SetValue(i, wrapped_item);
+	}
+	return decode_ticks;
+}
+
+template<size_t K, typename... P>
+uint64_t call_f(const OutBufferFunction<K, unsigned(*)(P...)>& func, const CefV8ValueList& args, CefRefPtr<CefV8Value>& retval)
+{
+	return invoke_out_buffer_f<K>(func.f, args, retval, std::index_sequence_for<P...>());
 }
 
 // API CEF HANDLER
@@ -892,7 +1128,7 @@ template<typename F> void create_handler(CefRefPtr<CefV8Value>& ns, const CefStr
 	class StingrayAPIHandler : public CefV8Handler
 	{
 	public:
-		StingrayAPIHandler(F func) : _func(func) {}
+		StingrayAPIHandler(F func) : _func(func), _stats(nullptr) {}
 
 		typedef F callback_handler_type;
 
@@ -904,17 +1140,26 @@ template<typename F> void create_handler(CefRefPtr<CefV8Value>& ns, const CefStr
 			CefString& exception) OVERRIDE
 		{
 			//if (name == "spawn_unit") DebugBreak();
+			const uint64_t start_ticks = api_profiler_ticks();
+			uint64_t decode_ticks = 0;
 			try {
-				call_f(_func, arguments, retval);
+				EngineApiScope scope;
+				decode_ticks = call_f(_func, arguments, retval);
 			} catch (std::exception& ex) {
 				exception = stingray::api::error->eprintf("Failed to execute %s.\r\n%s", name.ToString().c_str(), ex.what());
 			}
+			if (start_ticks != 0) {
+				if (_stats == nullptr)
+					_stats = get_api_call_stats(this, name);
+				record_api_call(_stats, start_ticks, decode_ticks);
+			}
 			return true;
 		}
 
 	private:
 
 		F _func;
+		ApiCallStats* _stats;
 		IMPLEMENT_REFCOUNTING(StingrayAPIHandler);
 	};
 
@@ -922,16 +1167,33 @@ template<typename F> void create_handler(CefRefPtr<CefV8Value>& ns, const CefStr
 	ns->SetValue(name, CefV8Value::CreateFunction(name, handler), V8_PROPERTY_ATTRIBUTE_READONLY);
 }
 
+// Base of the custom function handlers, tells the functions that don't use engine state from the others.
+class CustomApiHandler : public CefV8Handler
+{
+public:
+	virtual bool is_local() const = 0;
+};
+
+// Local functions run right away, so they have no `stingray.async` variant.
+inline bool is_local_api_handler(CefV8Handler* handler)
+{
+	CustomApiHandler* custom_handler = dynamic_cast<CustomApiHandler*>(handler);
+	return custom_handler != nullptr && custom_handler->is_local();
+}
+
 /**
- * Bind a custom function to namespace.
+ * Bind a custom function to namespace. Engine functions can't tell reads from writes, so they
+ * throw while the engine runs its frame. Local functions don't use engine state and always run.
  */
 typedef std::function<CefRefPtr<CefV8Value>(const CefV8ValueList&)> ExecuteHandlerFunction;
-inline void bind_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHandlerFunction func)
+inline void bind_custom_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHandlerFunction func, bool engine)
 {
-	class ExecuteHandler : public CefV8Handler
+	class ExecuteHandler : public CustomApiHandler
 	{
 	public:
-		ExecuteHandler(ExecuteHandlerFunction func) : _handler(func) {}
+		ExecuteHandler(ExecuteHandlerFunction func, bool engine) : _handler(func), _stats(nullptr), _engine(engine) {}
+
+		bool is_local() const OVERRIDE { return !_engine; }
 
 		bool Execute(
 			const CefString& name,
@@ -940,24 +1202,50 @@ inline void bind_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHa
 			CefRefPtr<CefV8Value>& retval,
 			CefString& exception) OVERRIDE
 		{
+			const uint64_t start_ticks = api_profiler_ticks();
 			try {
-				retval = _handler(arguments);
+				if (_engine) {
+					EngineApiScope scope;
+					if (scope.access != API_ACCESS_DIRECT)
+						throw std::exception(ENGINE_BUSY_ERROR);
+					retval = _handler(arguments);
+				} else {
+					retval = _handler(arguments);
+				}
 			} catch (std::exception& ex) {
 				exception = stingray::api::error->eprintf("Failed to execute %s.\r\n%s", name.ToString().c_str(), ex.what());
 			}
+			if (start_ticks != 0) {
+				// Custom handlers decode their own arguments, so no decode time is reported.
+				if (_stats == nullptr)
+					_stats = get_api_call_stats(this, name);
+				record_api_call(_stats, start_ticks, 0);
+			}
 			return true;
 		}
 
 	private:
 
 		ExecuteHandlerFunction _handler;
+		ApiCallStats* _stats;
+		bool _engine;
 		IMPLEMENT_REFCOUNTING(ExecuteHandler);
 	};
 
-	auto handler = new ExecuteHandler(func);
+	auto handler = new ExecuteHandler(func, engine);
 	ns->SetValue(name, CefV8Value::CreateFunction(name, handler), V8_PROPERTY_ATTRIBUTE_READONLY);
 }
 
+inline void bind_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHandlerFunction func)
+{
+	bind_custom_api(ns, name, func, true);
+}
+
+inline void bind_local_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHandlerFunction func)
+{
+	bind_custom_api(ns, name, func, false);
+}
+
 /**
  * Bind C-API to namespace.
  */
@@ -965,5 +1253,6 @@ inline void bind_api(CefRefPtr<CefV8Value>& ns, const CefString& name, ExecuteHa
 	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr); \
 	stingray_ns->SetValue(name, ns, V8_PROPERTY_ATTRIBUTE_READONLY)
 #define BIND_API(NAME) create_handler(ns, #NAME, api->NAME);
+#define BIND_API_OUT_BUFFER(NAME, INDEX) create_handler(ns, #NAME, out_buffer_function<INDEX>(api->NAME));
 
 } // end namespace
@@ -0,0 +1,25 @@
+// Generated by tools/bindgen.rb from c_api_line_object.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb line_object`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_line_object(CefRefPtr<CefV8Value> stingray_ns, const LineObjectCApi* api)
+{
+	DEFINE_API("LineObject");
+
+	BIND_API(dispatch);
+	BIND_API(reset);
+	BIND_API(add_line);
+	BIND_API(add_cone);
+	BIND_API(add_circle);
+	BIND_API(add_sphere);
+	BIND_API(add_half_sphere);
+	BIND_API(add_box);
+	BIND_API(add_capsule);
+	BIND_API(add_axes);
+	BIND_API(add_unit_meshes);
+}
+
+} // end namespace
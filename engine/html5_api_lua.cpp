@@ -1,6 +1,10 @@
 #include "html5_api.h"
+#include "html5_web_app.h"
 #include "html5_web_view.h"
 #include "html5_api_bindings.h"
+#include "html5_event_stream.h"
+#include "html5_structured_clone.h"
+#include "html5_web_page.h"
 
 #include <engine_plugin_api/plugin_api.h>
 #include <engine_plugin_api/c_api/c_api_window.h>
@@ -15,11 +19,27 @@ namespace PLUGIN_NAMESPACE {
 
 class LuaWebApp : public CefClient,
 	public CefLifeSpanHandler,
-	public CefDisplayHandler
+	public CefDisplayHandler,
+	public CefRequestHandler
 {
 public:
 
+	LuaWebApp() : _pipelined(false)
+	{
+		CefMessageRouterConfig config;
+		config.js_query_function = "cefQuery";
+		config.js_cancel_function = "cefCancel";
+		_message_router = CefMessageRouterBrowserSide::Create(config);
+	}
+
 	bool is_ready() const { return !!_browser; }
+	bool is_pipelined() const { return _pipelined; }
+	void set_pipelined(bool pipelined)
+	{
+		_pipelined = pipelined;
+		if (_browser)
+			set_web_app_pipelined(_browser->GetIdentifier(), pipelined);
+	}
 
 	bool emit_event(const char* event_name, const char* detail = "{}") const
 	{
@@ -31,6 +51,31 @@ public:
 		return execute(event_script);
 	}
 
+	// Calls a page function without compiling any script. The renderer signals the engine sync once done.
+	bool call(WebAppFunction function, double dt = 0.0) const
+	{
+		if (!_browser)
+			return false;
+		auto message = CefProcessMessage::Create(WEB_APP_CALL_MESSAGE);
+		message->GetArgumentList()->SetInt(0, function);
+		message->GetArgumentList()->SetDouble(1, dt);
+		if (_browser->SendProcessMessage(PID_RENDERER, message))
+			return true;
+		sync_signal();
+		return false;
+	}
+
+	// Dispatches a page event with a structured clone as detail, decoded by the renderer without compiling any script.
+	bool send_event(const char* event_name, const std::vector<char>& detail) const
+	{
+		if (!_browser)
+			return false;
+		auto message = CefProcessMessage::Create(WEB_APP_EVENT_MESSAGE);
+		message->GetArgumentList()->SetString(0, event_name);
+		message->GetArgumentList()->SetBinary(1, CefBinaryValue::Create(detail.data(), detail.size()));
+		return _browser->SendProcessMessage(PID_RENDERER, message);
+	}
+
 	bool execute(const char* script) const
 	{
 		if (!_browser)
@@ -50,11 +95,36 @@ protected: // CefClient
 
 	CefRefPtr<CefLifeSpanHandler> GetLifeSpanHandler() OVERRIDE { return this; }
 	CefRefPtr<CefDisplayHandler> GetDisplayHandler() OVERRIDE { return this; }
+	CefRefPtr<CefRequestHandler> GetRequestHandler() OVERRIDE { return this; }
+
+	bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefProcessId source_process, CefRefPtr<CefProcessMessage> message) OVERRIDE
+	{
+		return _message_router->OnProcessMessageReceived(browser, source_process, message);
+	}
 
 protected: // CefLifeSpanHandler
 
-	void OnAfterCreated(CefRefPtr<CefBrowser> browser) OVERRIDE { _browser = browser; }
-	void OnBeforeClose(CefRefPtr<CefBrowser> browser) OVERRIDE { _browser = nullptr; }
+	void OnAfterCreated(CefRefPtr<CefBrowser> browser) OVERRIDE
+	{
+		_message_router->AddHandler(event_stream_handler(), false);
+
+		CefRefPtr<LuaWebApp> web_app = this;
+		WebApp::run_on_engine_thread([web_app, browser]() {
+			web_app->_browser = browser;
+			if (web_app->_pipelined)
+				set_web_app_pipelined(browser->GetIdentifier(), true);
+		});
+	}
+
+	void OnBeforeClose(CefRefPtr<CefBrowser> browser) OVERRIDE
+	{
+		_message_router->OnBeforeClose(browser);
+		release_web_pages(browser->GetIdentifier());
+		set_web_app_pipelined(browser->GetIdentifier(), false);
+
+		CefRefPtr<LuaWebApp> web_app = this;
+		WebApp::run_on_engine_thread([web_app]() { web_app->_browser = nullptr; });
+	}
 
 protected: // CefDisplayHandler
 
@@ -64,9 +134,24 @@ protected: // CefDisplayHandler
 		return false;
 	}
 
+protected: // CefRequestHandler
+
+	bool OnBeforeBrowse(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefRequest>, bool) OVERRIDE
+	{
+		_message_router->OnBeforeBrowse(browser, frame);
+		return false;
+	}
+
+	void OnRenderProcessTerminated(CefRefPtr<CefBrowser> browser, TerminationStatus) OVERRIDE
+	{
+		_message_router->OnRenderProcessTerminated(browser);
+	}
+
 private:
 
 	CefRefPtr<CefBrowser> _browser;
+	CefRefPtr<CefMessageRouterBrowserSide> _message_router;
+	bool _pipelined;
 	IMPLEMENT_REFCOUNTING(LuaWebApp)
 };
 
@@ -160,11 +245,15 @@ void load_lua_api(LuaApi* env)
 			return 0;
 
 		auto dt = stingray::api::lua->tonumber(L, 2);
-		char update_call_script[128];
-		sprintf(update_call_script, "if (typeof window.update === 'function') window.update(%f); stingray.WebApp.sync();", dt);
+		if (web_app->is_pipelined()) {
+			begin_pipelined_sync();
+			web_app->call(WEB_APP_UPDATE, dt);
+			return 0;
+		}
+
 		// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
 		SyncEngine sync;
-		web_app->execute(update_call_script);
+		web_app->call(WEB_APP_UPDATE, dt);
 		return 0;
 	});
 
@@ -181,9 +270,150 @@ void load_lua_api(LuaApi* env)
 		if (!web_app->is_ready())
 			return 0;
 
+		if (web_app->is_pipelined()) {
+			begin_pipelined_sync();
+			web_app->call(WEB_APP_RENDER);
+			return 0;
+		}
+
 		// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
 		SyncEngine sync;
-		web_app->execute("if (typeof window.render === 'function') window.render(); stingray.WebApp.sync();");
+		web_app->call(WEB_APP_RENDER);
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.set_async_batch_size(batch_size:number) : nil
+	   @arg batch_size			Maximum number of `stingray.async` calls run per frame.
+	   @des Bound the number of queued `stingray.async` JavaScript calls the engine runs every frame. Remaining calls run next frames.
+	*/
+	env->add_module_function("WebApp", "set_async_batch_size", [](lua_State* L)
+	{
+		set_async_api_batch_size((unsigned)stingray::api::lua->tointeger(L, 1));
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.set_pump_budget(budget:number, max_slices:number) : nil
+	   @arg budget				Time in milliseconds the CEF message pump can use per frame.
+	   @arg max_slices			Maximum number of pump slices per frame.
+	   @des Bound the CEF message pump work done every frame. The pump only runs when CEF scheduled work.
+	*/
+	env->add_module_function("WebApp", "set_pump_budget", [](lua_State* L)
+	{
+		WebApp::set_pump_budget(stingray::api::lua->tonumber(L, 1), (unsigned)stingray::api::lua->tointeger(L, 2));
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.pump_stats() : number, number
+	   @ret number	Number of CEF message pump slices run last frame.
+	   @ret number	Time in milliseconds spent pumping last frame.
+	   @des Returns the CEF message pump activity of the last frame.
+	*/
+	env->add_module_function("WebApp", "pump_stats", [](lua_State* L)
+	{
+		const WebAppPumpStats stats = WebApp::last_pump_stats();
+		stingray::api::lua->pushinteger(L, stats.pumps);
+		stingray::api::lua->pushnumber(L, stats.duration_ms);
+		return 2;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.send_event(web_app:stingray.WebApp, name:string, detail:any) : boolean
+	   @arg web_app				Web app receiving the event.
+	   @arg name				Name of the `CustomEvent` dispatched on the page window.
+	   @arg detail				Nil, boolean, number, string or table of those, used as the event detail.
+	   @ret boolean				True if the event was sent.
+	   @des Dispatch an event on the page with a copy of a Lua value as detail. The value is sent in a compact
+	        binary format and created as JavaScript objects by the page, without generating any script.
+	*/
+	env->add_module_function("WebApp", "send_event", [](lua_State* L)
+	{
+		if (!web_apps)
+			return 0;
+
+		CefRefPtr<LuaWebApp> web_app = get_web_app(L, 1);
+		const char* name = stingray::api::lua->tolstring(L, 2, nullptr);
+
+		std::vector<char> detail;
+		if (!clone_lua_value(L, 3, detail))
+			return stingray::api::lua->lib_error(L, "Event detail of `%s` can only hold nil, booleans, numbers, strings and tables.", name);
+		stingray::api::lua->pushboolean(L, web_app->send_event(name, detail));
+		return 1;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.publish(topic:string, data:string) : boolean
+	   @arg topic				Name of the event stream topic.
+	   @arg data				Binary payload of the event.
+	   @ret boolean				False if a subscriber backlog is full and the event was dropped.
+	   @des Queue an event for the pages subscribed to the topic. Queued events are sent once per frame.
+	*/
+	env->add_module_function("WebApp", "publish", [](lua_State* L)
+	{
+		size_t size = 0;
+		const char* topic = stingray::api::lua->tolstring(L, 1, nullptr);
+		const char* data = stingray::api::lua->tolstring(L, 2, &size);
+		stingray::api::lua->pushboolean(L, publish_event(topic, data, (unsigned)size));
+		return 1;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.set_event_stream_limits(batch_bytes:number, backlog_bytes:number) : nil
+	   @arg batch_bytes			Bytes sent to a subscription per frame.
+	   @arg backlog_bytes		Bytes a subscription can keep queued before new events are dropped.
+	   @des Configure the batching and backpressure of the event streams.
+	*/
+	env->add_module_function("WebApp", "set_event_stream_limits", [](lua_State* L)
+	{
+		set_event_stream_limits((unsigned)stingray::api::lua->tointeger(L, 1), (unsigned)stingray::api::lua->tointeger(L, 2));
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.set_page_memory_budget(bytes:number) : nil
+	   @arg bytes				Bytes of web page data kept in memory.
+	   @des Loaded pages are copied out of their resource package, so the resources being served stay
+	        valid when the package is unloaded or reloaded. Once over budget, the least recently used
+	        pages drop their preloaded resources, decoded block by block again the next time a view
+	        requests them, and the pages no view uses are unloaded until a view requests them again.
+	        Pages views use are never unloaded, so usage can stay over budget. Defaults to 64 MB.
+	*/
+	env->add_module_function("WebApp", "set_page_memory_budget", [](lua_State* L)
+	{
+		set_web_page_memory_budget((uint64_t)stingray::api::lua->tonumber(L, 1));
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.page_memory() : number
+	   @ret number	Bytes of web page data currently in memory.
+	   @des Counts the loaded pages, the preloaded resources and the blocks being served, see `WebApp.set_page_memory_budget`.
+	*/
+	env->add_module_function("WebApp", "page_memory", [](lua_State* L)
+	{
+		stingray::api::lua->pushnumber(L, (double)web_page_memory_usage());
+		return 1;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebApp.set_pipelined(web_app:stingray.WebApp, enabled:boolean) : nil
+	   @arg web_app				Web app to configure.
+	   @arg enabled				Set to true to let the web app update and render overlap with the engine frame.
+	   @des In pipelined mode `WebApp.update` and `WebApp.render` return without waiting for the page. Bound
+	        functions without result called by the page are queued and applied at the start of the next
+	        engine frame, where the engine waits for the page to finish. Functions returning a value throw
+	        while the engine runs its frame, the page reads engine state through `stingray.async` instead.
+	*/
+	env->add_module_function("WebApp", "set_pipelined", [](lua_State* L)
+	{
+		if (!web_apps)
+			return 0;
+
+		CefRefPtr<LuaWebApp> web_app = get_web_app(L, 1);
+		end_pipelined_sync();
+		web_app->set_pipelined(stingray::api::lua->toboolean(L, 2) != 0);
 		return 0;
 	});
 
@@ -202,7 +432,7 @@ void load_lua_api(LuaApi* env)
 		{
 			// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
 			SyncEngine sync;
-			web_app->execute("if (typeof window.shutdown === 'function') window.shutdown(); stingray.WebApp.sync();");
+			web_app->call(WEB_APP_SHUTDOWN);
 		}
 		web_app->close();
 		web_apps->erase(web_app);
@@ -213,6 +443,20 @@ void load_lua_api(LuaApi* env)
 		return 0;
 	});
 
+	/* @adoc lua
+	   @sig stingray.WebApp.set_sync_deadline(deadline:number, policy:string) : nil
+	   @arg deadline			Maximum time in milliseconds the engine waits for a web app update or render.
+	   @arg policy				`"skip"` to let the engine frame continue, or `"log"` to report the stall and keep waiting.
+	   @des Configure how long the engine waits for web apps to sync. With `"skip"`, a late page keeps running concurrently with the engine frame.
+	*/
+	env->add_module_function("WebApp", "set_sync_deadline", [](lua_State* L)
+	{
+		const unsigned deadline_ms = (unsigned)stingray::api::lua->tointeger(L, 1);
+		const char* policy = stingray::api::lua->isstring(L, 2) ? stingray::api::lua->tolstring(L, 2, nullptr) : "skip";
+		set_sync_deadline(deadline_ms, strcmp(policy, "log") == 0 ? SYNC_TIMEOUT_LOG : SYNC_TIMEOUT_SKIP);
+		return 0;
+	});
+
 	/* @adoc lua
 	   @sig stingray.WebView.create(url:string, material:Material) : stingray.WebView
 	   @arg url				URL to load the  the web view at creation.
@@ -394,12 +638,91 @@ void load_lua_api(LuaApi* env)
 		WebView::on_cursor_pos(web_view.get(), x, y);
 		return 0;
 	});
+
+	/* @adoc lua
+	   @sig stingray.WebProfiler.enable(enabled:boolean) : nil
+	   @arg enabled			Set to true to record JavaScript binding calls.
+	   @des Enable or disable the `stingray.*` JavaScript binding call profiler.
+	*/
+	env->add_module_function("WebProfiler", "enable", [](lua_State *L) {
+		enable_api_profiler(stingray::api::lua->toboolean(L, 1) != 0);
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebProfiler.reset() : nil
+	   @des Reset the JavaScript binding call counters.
+	*/
+	env->add_module_function("WebProfiler", "reset", [](lua_State *L) {
+		reset_api_profiler();
+		return 0;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebProfiler.stats() : table
+	   @ret table	Table keyed by function name of `{calls, total, max, decode}` tables, times in milliseconds.
+	   @des Returns the JavaScript binding call counters.
+	*/
+	env->add_module_function("WebProfiler", "stats", [](lua_State *L) {
+		const auto snapshot = api_profiler_snapshot();
+		auto lua = stingray::api::lua;
+		lua->createtable(L, 0, (int)snapshot.size());
+		for (const auto& stats : snapshot) {
+			lua->createtable(L, 0, 4);
+			lua->pushnumber(L, stats.calls);
+			lua->setfield(L, -2, "calls");
+			lua->pushnumber(L, stingray::api::timer->ticks_to_seconds(stats.total_ticks) * 1000.0);
+			lua->setfield(L, -2, "total");
+			lua->pushnumber(L, stingray::api::timer->ticks_to_seconds(stats.max_ticks) * 1000.0);
+			lua->setfield(L, -2, "max");
+			lua->pushnumber(L, stingray::api::timer->ticks_to_seconds(stats.decode_ticks) * 1000.0);
+			lua->setfield(L, -2, "decode");
+			lua->setfield(L, -2, stats.name.c_str());
+		}
+		return 1;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebProfiler.engine_stats() : table
+	   @ret table	Table keyed by counter name of `{count, total, max}` tables, times in milliseconds.
+	   @des Returns the engine side counters, such as the time spent waiting for web app syncs.
+	*/
+	env->add_module_function("WebProfiler", "engine_stats", [](lua_State *L) {
+		const auto snapshot = engine_counters_snapshot();
+		auto lua = stingray::api::lua;
+		lua->createtable(L, 0, (int)snapshot.size());
+		for (const auto& stats : snapshot) {
+			lua->createtable(L, 0, 3);
+			lua->pushnumber(L, stats.count);
+			lua->setfield(L, -2, "count");
+			lua->pushnumber(L, stingray::api::timer->ticks_to_seconds(stats.total_ticks) * 1000.0);
+			lua->setfield(L, -2, "total");
+			lua->pushnumber(L, stingray::api::timer->ticks_to_seconds(stats.max_ticks) * 1000.0);
+			lua->setfield(L, -2, "max");
+			lua->setfield(L, -2, stats.name);
+		}
+		return 1;
+	});
+
+	/* @adoc lua
+	   @sig stingray.WebProfiler.dump(path:string?) : string
+	   @arg path	Optional file path to write the CSV report to.
+	   @ret string	CSV report of the JavaScript binding call counters.
+	   @des Returns and optionally writes the JavaScript binding call counters as CSV.
+	*/
+	env->add_module_function("WebProfiler", "dump", [](lua_State *L) {
+		if (stingray::api::lua->isstring(L, 1))
+			dump_api_profiler(stingray::api::lua->tolstring(L, 1, nullptr));
+		stingray::api::lua->pushstring(L, api_profiler_csv().c_str());
+		return 1;
+	});
 }
 
 void unload_lua_api(LuaApi* env)
 {
 	env->remove_all_module_entries("WebApp");
 	env->remove_all_module_entries("WebView");
+	env->remove_all_module_entries("WebProfiler");
 
 	// Release web app resources.
 	if (!web_apps)
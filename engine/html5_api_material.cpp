@@ -0,0 +1,23 @@
+// Generated by tools/bindgen.rb from c_api_material.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb material`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_material(CefRefPtr<CefV8Value> stingray_ns, const MaterialCApi* api)
+{
+	DEFINE_API("Material");
+
+	BIND_API(set_scalar);
+	BIND_API(set_vector2);
+	BIND_API(set_vector3);
+	BIND_API(set_vector4);
+	BIND_API(material_id);
+	BIND_API(set_shader_pass_flag);
+	BIND_API(set_texture);
+	BIND_API(set_resource);
+	BIND_API(set_matrix4x4);
+}
+
+} // end namespace
@@ -14,7 +14,7 @@ void bind_api_matrix4x4(CefRefPtr<CefV8Value> stingray_ns)
 	create_handler(ns, "zero", matrix4x4_zero);
 	create_handler(ns, "identity", matrix4x4_identity);
 	create_handler(ns, "identity", matrix4x4_identity);
-	bind_api(ns, "forward_axis", [](const CefV8ValueList& args)
+	bind_local_api(ns, "forward_axis", [](const CefV8ValueList& args)
 	{
 		const Matrix4x4& m = get_arg<Matrix4x4>(args, 0);
 		CefRefPtr<CefV8Value> retval;
@@ -23,7 +23,7 @@ void bind_api_matrix4x4(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "from_quaternion", [](const CefV8ValueList& args)
+	bind_local_api(ns, "from_quaternion", [](const CefV8ValueList& args)
 	{
 		const Quaternion& q = get_arg<Quaternion>(args, 0);
 		CefRefPtr<CefV8Value> retval;
@@ -32,28 +32,28 @@ void bind_api_matrix4x4(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "x", [](const CefV8ValueList& args)
+	bind_local_api(ns, "x", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(x_axis(get_arg<Matrix4x4>(args, 0)), retval);
 		return retval;
 	});
 
-	bind_api(ns, "y", [](const CefV8ValueList& args)
+	bind_local_api(ns, "y", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(y_axis(get_arg<Matrix4x4>(args, 0)), retval);
 		return retval;
 	});
 
-	bind_api(ns, "z", [](const CefV8ValueList& args)
+	bind_local_api(ns, "z", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(z_axis(get_arg<Matrix4x4>(args, 0)), retval);
 		return retval;
 	});
 
-	bind_api(ns, "transform", [](const CefV8ValueList& args)
+	bind_local_api(ns, "transform", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(transform(get_arg<Matrix4x4>(args, 0), get_arg<Vector3>(args, 1)), retval);
@@ -67,14 +67,14 @@ void bind_api_vector2(CefRefPtr<CefV8Value> stingray_ns)
 {
 	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr);
 
-	bind_api(ns, "zero", [](const CefV8ValueList& args)
+	bind_local_api(ns, "zero", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(vector2(0,0), retval);
 		return retval;
 	});
 
-	bind_api(ns, "create", [](const CefV8ValueList& args)
+	bind_local_api(ns, "create", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		float v1 = get_arg<float>(args, 0);
@@ -83,12 +83,12 @@ void bind_api_vector2(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "equal", [](const CefV8ValueList& args)
+	bind_local_api(ns, "equal", [](const CefV8ValueList& args)
 	{
 		return CefV8Value::CreateBool(get_arg<Vector2>(args, 0) == get_arg<Vector2>(args, 1));
 	});
 
-	bind_api(ns, "normalize", [](const CefV8ValueList& args)
+	bind_local_api(ns, "normalize", [](const CefV8ValueList& args)
 	{
 		const Vector2& nv = normalize(get_arg<Vector2>(args, 0));
 		CefRefPtr<CefV8Value> retval;
@@ -96,34 +96,34 @@ void bind_api_vector2(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "add", [](const CefV8ValueList& args)
+	bind_local_api(ns, "add", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector2>(args, 0) + get_arg<Vector2>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "subtract", [](const CefV8ValueList& args)
+	bind_local_api(ns, "subtract", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector2>(args, 0) - get_arg<Vector2>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector2>(args, 0) * get_arg<float>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply_elements", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply_elements", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector2>(args, 0) * get_arg<Vector2>(args, 1), retval);
 		return retval;
 	});
-	bind_api(ns, "dot", [](const CefV8ValueList& args)
+	bind_local_api(ns, "dot", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(dot(get_arg<Vector2>(args, 0), get_arg<Vector2>(args, 1)), retval);
@@ -136,19 +136,19 @@ void bind_api_vector3(CefRefPtr<CefV8Value> stingray_ns)
 {
 	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr);
 
-	bind_api(ns, "zero", [](const CefV8ValueList& args)
+	bind_local_api(ns, "zero", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(vector3(0,0,0), retval);
 		return retval;
 	});
 
-	bind_api(ns, "equal", [](const CefV8ValueList& args)
+	bind_local_api(ns, "equal", [](const CefV8ValueList& args)
 	{
 		return CefV8Value::CreateBool(get_arg<Vector3>(args, 0) == get_arg<Vector3>(args, 1));
 	});
 
-	bind_api(ns, "normalize", [](const CefV8ValueList& args)
+	bind_local_api(ns, "normalize", [](const CefV8ValueList& args)
 	{
 		const Vector3& nv = normalize(get_arg<Vector3>(args, 0));
 		CefRefPtr<CefV8Value> retval;
@@ -156,35 +156,35 @@ void bind_api_vector3(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "add", [](const CefV8ValueList& args)
+	bind_local_api(ns, "add", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector3>(args, 0) + get_arg<Vector3>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "subtract", [](const CefV8ValueList& args)
+	bind_local_api(ns, "subtract", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector3>(args, 0) - get_arg<Vector3>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector3>(args, 0) * get_arg<float>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply_elements", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply_elements", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector3>(args, 0) * get_arg<Vector3>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "dot", [](const CefV8ValueList& args)
+	bind_local_api(ns, "dot", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(dot(get_arg<Vector3>(args, 0), get_arg<Vector3>(args, 1)), retval);
@@ -198,14 +198,14 @@ void bind_api_vector4(CefRefPtr<CefV8Value> stingray_ns)
 {
 	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr);
 
-	bind_api(ns, "zero", [](const CefV8ValueList& args)
+	bind_local_api(ns, "zero", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(vector4(0,0,0,0), retval);
 		return retval;
 	});
 
-	bind_api(ns, "create", [](const CefV8ValueList& args)
+	bind_local_api(ns, "create", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		float v1 = get_arg<float>(args, 0);
@@ -216,12 +216,12 @@ void bind_api_vector4(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "equal", [](const CefV8ValueList& args)
+	bind_local_api(ns, "equal", [](const CefV8ValueList& args)
 	{
 		return CefV8Value::CreateBool(get_arg<Vector4>(args, 0) == get_arg<Vector4>(args, 1));
 	});
 
-	bind_api(ns, "normalize", [](const CefV8ValueList& args)
+	bind_local_api(ns, "normalize", [](const CefV8ValueList& args)
 	{
 		const Vector4& nv = normalize(get_arg<Vector4>(args, 0));
 		CefRefPtr<CefV8Value> retval;
@@ -229,34 +229,34 @@ void bind_api_vector4(CefRefPtr<CefV8Value> stingray_ns)
 		return retval;
 	});
 
-	bind_api(ns, "add", [](const CefV8ValueList& args)
+	bind_local_api(ns, "add", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector4>(args, 0) + get_arg<Vector4>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "subtract", [](const CefV8ValueList& args)
+	bind_local_api(ns, "subtract", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector4>(args, 0) - get_arg<Vector4>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector4>(args, 0) * get_arg<float>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply_elements", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply_elements", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Vector4>(args, 0) * get_arg<Vector4>(args, 1), retval);
 		return retval;
 	});
-	bind_api(ns, "dot", [](const CefV8ValueList& args)
+	bind_local_api(ns, "dot", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(dot(get_arg<Vector4>(args, 0), get_arg<Vector4>(args, 1)), retval);
@@ -269,42 +269,42 @@ void bind_api_quaternion(CefRefPtr<CefV8Value> stingray_ns)
 {
 	CefRefPtr<CefV8Value> ns = CefV8Value::CreateObject(nullptr, nullptr);
 
-	bind_api(ns, "identity", [](const CefV8ValueList& args)
+	bind_local_api(ns, "identity", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(quaternion_identity(), retval);
 		return retval;
 	});
 
-	bind_api(ns, "multiply", [](const CefV8ValueList& args)
+	bind_local_api(ns, "multiply", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(get_arg<Quaternion>(args, 0) * get_arg<Quaternion>(args, 1), retval);
 		return retval;
 	});
 
-	bind_api(ns, "forward", [](const CefV8ValueList& args)
+	bind_local_api(ns, "forward", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(forward_axis(matrix4x4(get_arg<Quaternion>(args, 0))), retval);
 		return retval;
 	});
 
-	bind_api(ns, "up", [](const CefV8ValueList& args)
+	bind_local_api(ns, "up", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(up_axis(matrix4x4(get_arg<Quaternion>(args, 0))), retval);
 		return retval;
 	});
 
-	bind_api(ns, "right", [](const CefV8ValueList& args)
+	bind_local_api(ns, "right", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(right_axis(matrix4x4(get_arg<Quaternion>(args, 0))), retval);
 		return retval;
 	});
 
-	bind_api(ns, "axis_angle", [](const CefV8ValueList& args)
+	bind_local_api(ns, "axis_angle", [](const CefV8ValueList& args)
 	{
 		CefRefPtr<CefV8Value> retval;
 		wrap_result(quaternion(get_arg<Vector3>(args, 0), get_arg<float>(args, 1)), retval);
@@ -0,0 +1,32 @@
+// Generated by tools/bindgen.rb from c_api_mesh.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb mesh`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_mesh(CefRefPtr<CefV8Value> stingray_ns, const MeshCApi* api)
+{
+	DEFINE_API("Mesh");
+
+	BIND_API(num_materials);
+	BIND_API(find_material);
+	BIND_API(material);
+	BIND_API(node);
+	BIND_API(set_shader_pass_flag);
+	BIND_API(bounding_volume);
+	BIND_API(set_explicit_sort_value);
+	BIND_API(local_position);
+	BIND_API(local_rotation);
+	BIND_API(local_scale);
+	BIND_API(local_pose);
+	BIND_API(set_local_position);
+	BIND_API(set_local_rotation);
+	BIND_API(set_local_scale);
+	BIND_API(set_local_pose);
+	BIND_API(world_position);
+	BIND_API(world_pose);
+	BIND_API(world_rotation);
+}
+
+} // end namespace
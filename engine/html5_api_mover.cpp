@@ -0,0 +1,30 @@
+// Generated by tools/bindgen.rb from c_api_mover.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb mover`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_mover(CefRefPtr<CefV8Value> stingray_ns, const MoverCApi* api)
+{
+	DEFINE_API("Mover");
+
+	BIND_API(unit);
+	BIND_API(set_position);
+	BIND_API(position);
+	BIND_API(move);
+	BIND_API(separate);
+	BIND_API(fits_at);
+	BIND_API(collides_down);
+	BIND_API(collides_up);
+	BIND_API(collides_sides);
+	BIND_API(actor_colliding_down);
+	BIND_API(standing_frames);
+	BIND_API(flying_frames);
+	BIND_API(set_collision_filter);
+	BIND_API(max_slope_angle);
+	BIND_API(set_max_slope_angle);
+	BIND_API(radius);
+}
+
+} // end namespace
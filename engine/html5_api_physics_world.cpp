@@ -0,0 +1,22 @@
+// Generated by tools/bindgen.rb from c_api_physics_world.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb physics_world`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_physics_world(CefRefPtr<CefV8Value> stingray_ns, const PhysicsWorldCApi* api)
+{
+	DEFINE_API("PhysicsWorld");
+
+	BIND_API_OUT_BUFFER(raycast, 0);
+	BIND_API_OUT_BUFFER(cast, 1);
+	BIND_API(make_raycast);
+	BIND_API(destroy_raycast);
+	BIND_API_OUT_BUFFER(overlap, 0);
+	BIND_API_OUT_BUFFER(linear_sphere_sweep, 0);
+	BIND_API_OUT_BUFFER(linear_capsule_sweep, 0);
+	BIND_API_OUT_BUFFER(linear_obb_sweep, 0);
+}
+
+} // end namespace
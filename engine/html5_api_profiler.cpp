@@ -0,0 +1,265 @@
+#include "html5_api_profiler.h"
+#include "html5_api_bindings.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+std::atomic<bool> api_profiler_enabled(false);
+
+// Stats are recorded from the render thread and queried from the main thread.
+static ThreadCriticalSection* api_profiler_cs = nullptr;
+static std::unordered_map<const CefV8Handler*, std::string>* api_function_names = nullptr;
+static std::unordered_map<std::string, std::unique_ptr<ApiCallStats>>* api_call_stats = nullptr;
+
+// Engine counters are updated from the main thread and read from any, without the lock.
+struct EngineCounterSlot
+{
+	const char* name;
+	std::atomic<unsigned> count;
+	std::atomic<uint64_t> total_ticks;
+	std::atomic<uint64_t> max_ticks;
+};
+
+static EngineCounterSlot engine_counters[ENGINE_COUNTER_COUNT] = {
+	{ "cef_main_thread" },
+	{ "sync_wait" },
+	{ "sync_timeout" },
+	{ "sync_skip" }
+};
+
+struct ApiProfilerLock
+{
+	ApiProfilerLock() { stingray::api::thread->enter_critical_section(api_profiler_cs); }
+	~ApiProfilerLock() { stingray::api::thread->leave_critical_section(api_profiler_cs); }
+};
+
+static double ticks_to_ms(uint64_t ticks)
+{
+	return stingray::api::timer->ticks_to_seconds(ticks) * 1000.0;
+}
+
+void setup_api_profiler()
+{
+	api_profiler_cs = stingray::api::thread->create_critical_section(stingray::api::allocator_object);
+	api_function_names = new std::unordered_map<const CefV8Handler*, std::string>();
+	api_call_stats = new std::unordered_map<std::string, std::unique_ptr<ApiCallStats>>();
+}
+
+void shutdown_api_profiler()
+{
+	api_profiler_enabled = false;
+
+	delete api_call_stats;
+	api_call_stats = nullptr;
+	delete api_function_names;
+	api_function_names = nullptr;
+
+	stingray::api::thread->destroy_critical_section(api_profiler_cs, stingray::api::allocator_object);
+	api_profiler_cs = nullptr;
+}
+
+void enable_api_profiler(bool enabled)
+{
+	api_profiler_enabled = enabled;
+}
+
+void reset_api_profiler()
+{
+	for (auto& counter : engine_counters) {
+		counter.count = 0;
+		counter.total_ticks = 0;
+		counter.max_ticks = 0;
+	}
+
+	ApiProfilerLock lock;
+	for (auto& it : *api_call_stats) {
+		ApiCallStats& stats = *it.second;
+		stats.calls = 0;
+		stats.total_ticks = stats.max_ticks = stats.decode_ticks = 0;
+	}
+}
+
+void name_api_function(const CefV8Handler* handler, const std::string& name)
+{
+	ApiProfilerLock lock;
+	(*api_function_names)[handler] = name;
+}
+
+ApiCallStats* get_api_call_stats(const CefV8Handler* handler, const CefString& name)
+{
+	ApiProfilerLock lock;
+	auto function_name = api_function_names->find(handler);
+	const std::string key = function_name != api_function_names->end() ? function_name->second : name.ToString();
+
+	std::unique_ptr<ApiCallStats>& stats = (*api_call_stats)[key];
+	if (!stats) {
+		stats.reset(new ApiCallStats());
+		stats->name = key;
+		stats->calls = 0;
+		stats->total_ticks = stats->max_ticks = stats->decode_ticks = 0;
+	}
+	return stats.get();
+}
+
+void record_api_call(ApiCallStats* stats, uint64_t start_ticks, uint64_t decode_ticks)
+{
+	const uint64_t ticks = stingray::api::timer->ticks() - start_ticks;
+
+	ApiProfilerLock lock;
+	stats->calls++;
+	stats->total_ticks += ticks;
+	stats->decode_ticks += decode_ticks;
+	if (ticks > stats->max_ticks)
+		stats->max_ticks = ticks;
+}
+
+std::vector<ApiCallStats> api_profiler_snapshot()
+{
+	std::vector<ApiCallStats> snapshot;
+
+	ApiProfilerLock lock;
+	snapshot.reserve(api_call_stats->size());
+	for (const auto& it : *api_call_stats) {
+		if (it.second->calls > 0)
+			snapshot.push_back(*it.second);
+	}
+	return snapshot;
+}
+
+std::string api_profiler_csv()
+{
+	std::string csv = "name,calls,total_ms,max_ms,decode_ms\n";
+	for (const auto& stats : api_profiler_snapshot()) {
+		// Totals have no upper bound, so the line is sized by a first formatting pass.
+		const double total_ms = ticks_to_ms(stats.total_ticks);
+		const double max_ms = ticks_to_ms(stats.max_ticks);
+		const double decode_ms = ticks_to_ms(stats.decode_ticks);
+		const int size = snprintf(nullptr, 0, ",%u,%.4f,%.4f,%.4f\n", stats.calls, total_ms, max_ms, decode_ms);
+		if (size < 0)
+			continue;
+		std::vector<char> line(size + 1);
+		snprintf(line.data(), line.size(), ",%u,%.4f,%.4f,%.4f\n", stats.calls, total_ms, max_ms, decode_ms);
+		csv += stats.name;
+		csv += line.data();
+	}
+	return csv;
+}
+
+bool dump_api_profiler(const char* path)
+{
+	if (path == nullptr || path[0] == '\0')
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+
+	const std::string csv = api_profiler_csv();
+	const bool written = fwrite(csv.c_str(), 1, csv.size(), file) == csv.size();
+	fclose(file);
+	return written;
+}
+
+void record_engine_counter(EngineCounter counter, uint64_t ticks)
+{
+	EngineCounterSlot& c = engine_counters[counter];
+	c.count.fetch_add(1, std::memory_order_relaxed);
+	c.total_ticks.fetch_add(ticks, std::memory_order_relaxed);
+	uint64_t max_ticks = c.max_ticks.load(std::memory_order_relaxed);
+	while (ticks > max_ticks && !c.max_ticks.compare_exchange_weak(max_ticks, ticks, std::memory_order_relaxed)) {}
+}
+
+std::vector<EngineCounterStats> engine_counters_snapshot()
+{
+	std::vector<EngineCounterStats> snapshot;
+	for (const auto& counter : engine_counters) {
+		EngineCounterStats stats;
+		stats.name = counter.name;
+		stats.count = counter.count.load(std::memory_order_relaxed);
+		stats.total_ticks = counter.total_ticks.load(std::memory_order_relaxed);
+		stats.max_ticks = counter.max_ticks.load(std::memory_order_relaxed);
+		snapshot.push_back(stats);
+	}
+	return snapshot;
+}
+
+void bind_api_profiler(CefRefPtr<CefV8Value> stingray_ns)
+{
+	DEFINE_API("profiler");
+
+	// stingray.profiler.enable(enabled)
+	bind_local_api(ns, "enable", [](const CefV8ValueList& args)
+	{
+		enable_api_profiler(args.size() == 0 || args[0]->GetBoolValue());
+		return CefV8Value::CreateUndefined();
+	});
+
+	// stingray.profiler.enabled()
+	bind_local_api(ns, "enabled", [](const CefV8ValueList& args)
+	{
+		return CefV8Value::CreateBool(api_profiler_enabled);
+	});
+
+	// stingray.profiler.reset()
+	bind_local_api(ns, "reset", [](const CefV8ValueList& args)
+	{
+		reset_api_profiler();
+		return CefV8Value::CreateUndefined();
+	});
+
+	// stingray.profiler.stats() -> [{name, calls, total, max, decode}] in milliseconds
+	bind_local_api(ns, "stats", [](const CefV8ValueList& args)
+	{
+		const auto snapshot = api_profiler_snapshot();
+		auto result = CefV8Value::CreateArray((int)snapshot.size());
+		for (int i = 0; i < (int)snapshot.size(); ++i) {
+			const ApiCallStats& stats = snapshot[i];
+			auto item = CefV8Value::CreateObject(nullptr, nullptr);
+			item->SetValue("name", CefV8Value::CreateString(stats.name), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("calls", CefV8Value::CreateUInt(stats.calls), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("total", CefV8Value::CreateDouble(ticks_to_ms(stats.total_ticks)), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("max", CefV8Value::CreateDouble(ticks_to_ms(stats.max_ticks)), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("decode", CefV8Value::CreateDouble(ticks_to_ms(stats.decode_ticks)), V8_PROPERTY_ATTRIBUTE_NONE);
+			result->SetValue(i, item);
+		}
+		return result;
+	});
+
+	// stingray.profiler.csv()
+	bind_local_api(ns, "csv", [](const CefV8ValueList& args)
+	{
+		return CefV8Value::CreateString(api_profiler_csv());
+	});
+
+	// stingray.profiler.engine_stats() -> [{name, count, total, max}] in milliseconds
+	bind_local_api(ns, "engine_stats", [](const CefV8ValueList& args)
+	{
+		const auto snapshot = engine_counters_snapshot();
+		auto result = CefV8Value::CreateArray((int)snapshot.size());
+		for (int i = 0; i < (int)snapshot.size(); ++i) {
+			const EngineCounterStats& stats = snapshot[i];
+			auto item = CefV8Value::CreateObject(nullptr, nullptr);
+			item->SetValue("name", CefV8Value::CreateString(stats.name), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("count", CefV8Value::CreateUInt(stats.count), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("total", CefV8Value::CreateDouble(ticks_to_ms(stats.total_ticks)), V8_PROPERTY_ATTRIBUTE_NONE);
+			item->SetValue("max", CefV8Value::CreateDouble(ticks_to_ms(stats.max_ticks)), V8_PROPERTY_ATTRIBUTE_NONE);
+			result->SetValue(i, item);
+		}
+		return result;
+	});
+
+	// stingray.profiler.dump(path)
+	bind_local_api(ns, "dump", [](const CefV8ValueList& args)
+	{
+		if (args.size() != 1) throw std::exception("function takes 1 argument");
+		const char* path = get_arg<const char*>(args, 0);
+		if (path == nullptr || path[0] == '\0')
+			throw std::exception("path must be a non-empty string");
+		return CefV8Value::CreateBool(dump_api_profiler(path));
+	});
+}
+
+} // end namespace
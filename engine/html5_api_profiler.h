@@ -0,0 +1,74 @@
+#pragma once
+
+#include "stingray_api.h"
+
+#include <include/cef_v8.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Counters of a bound JavaScript function, in timer ticks.
+ */
+struct ApiCallStats
+{
+	std::string name;
+	unsigned calls;
+	uint64_t total_ticks;
+	uint64_t max_ticks;
+	uint64_t decode_ticks;
+};
+
+extern std::atomic<bool> api_profiler_enabled;
+
+/**
+ * Returns the current timer ticks if the binding profiler is enabled, 0 otherwise.
+ */
+inline uint64_t api_profiler_ticks()
+{
+	return api_profiler_enabled.load(std::memory_order_relaxed) ? stingray::api::timer->ticks() : 0;
+}
+
+/**
+ * Engine side timings, reported apart from the binding calls and always recorded.
+ */
+enum EngineCounter
+{
+	ENGINE_COUNTER_CEF_MAIN_THREAD,
+	ENGINE_COUNTER_SYNC_WAIT,
+	ENGINE_COUNTER_SYNC_TIMEOUT,
+	ENGINE_COUNTER_SYNC_SKIP,
+	ENGINE_COUNTER_COUNT
+};
+
+struct EngineCounterStats
+{
+	const char* name;
+	unsigned count;
+	uint64_t total_ticks;
+	uint64_t max_ticks;
+};
+
+void setup_api_profiler();
+void shutdown_api_profiler();
+void enable_api_profiler(bool enabled);
+void reset_api_profiler();
+
+// Handlers named by the namespace table report as `Namespace.function`, others by function name.
+void name_api_function(const CefV8Handler* handler, const std::string& name);
+ApiCallStats* get_api_call_stats(const CefV8Handler* handler, const CefString& name);
+void record_api_call(ApiCallStats* stats, uint64_t start_ticks, uint64_t decode_ticks);
+
+std::vector<ApiCallStats> api_profiler_snapshot();
+std::string api_profiler_csv();
+
+// Returns false if the path is null or empty or the file cannot be written.
+bool dump_api_profiler(const char* path);
+
+void record_engine_counter(EngineCounter counter, uint64_t ticks);
+std::vector<EngineCounterStats> engine_counters_snapshot();
+
+} // end namespace
@@ -0,0 +1,15 @@
+// Generated by tools/bindgen.rb from c_api_viewport.h, do not edit.
+// Regenerate with `ruby tools/bindgen.rb viewport`.
+
+#include "html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+void bind_api_viewport(CefRefPtr<CefV8Value> stingray_ns, const ViewportCApi* api)
+{
+	DEFINE_API("Viewport");
+
+	BIND_API(set_rect);
+}
+
+} // end namespace
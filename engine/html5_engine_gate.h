@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Lets page threads call into the engine only while the engine thread waits for the page.
+ *
+ * The engine thread opens the gate when it starts waiting and closes it before its frame goes on, closing waits for
+ * the calls that entered. A page thread must enter before calling the engine and must not call it when entering
+ * fails: the engine skipped its wait or never started it, and runs its frame.
+ */
+class EngineGate
+{
+public:
+
+	EngineGate() : _open(false), _calls(0) {}
+
+	// Engine thread
+
+	void open() { _open = true; }
+
+	void close()
+	{
+		_open = false;
+		while (_calls.load() > 0)
+			std::this_thread::yield();
+	}
+
+	// Page threads, a successful enter() is matched by leave().
+
+	bool enter()
+	{
+		// Count the call before checking, so the engine can't close in between.
+		++_calls;
+		if (_open.load())
+			return true;
+		--_calls;
+		return false;
+	}
+
+	void leave() { --_calls; }
+
+	bool is_open() const { return _open.load(); }
+
+private:
+
+	EngineGate(const EngineGate&) = delete;
+	EngineGate& operator=(const EngineGate&) = delete;
+
+	std::atomic<bool> _open;
+	std::atomic<int> _calls;
+};
+
+} // end namespace
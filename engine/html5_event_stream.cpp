@@ -0,0 +1,190 @@
+#include "html5_event_stream.h"
+#include "html5_web_app.h"
+
+#include "stingray_api.h"
+
+#include <plugin_foundation/id_string.h>
+
+#include <string>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+static const unsigned QUERY_HEADER_SIZE = 12;
+static const unsigned EVENT_HEADER_SIZE = 4;
+
+// Subscription of a page to a topic, events are kept encoded one byte per character until sent.
+struct EventSubscription
+{
+	int browser_id;
+	int64 query_id;
+	uint64_t topic;
+	CefRefPtr<CefMessageRouterBrowserSide::Callback> callback;
+	std::wstring backlog;
+	unsigned dropped;
+};
+
+// Subscriptions are only changed and flushed on the engine thread.
+static std::vector<EventSubscription>* subscriptions = nullptr;
+static unsigned event_batch_bytes = 64 * 1024;
+static unsigned event_backlog_bytes = 1024 * 1024;
+
+template <typename T> static T read_frame(const CefString::char_type* frame, unsigned offset)
+{
+	T value = 0;
+	for (unsigned i = 0; i < sizeof(T); ++i)
+		value |= (T)(frame[offset + i] & 0xFF) << (i * 8);
+	return value;
+}
+
+static void remove_subscription(int browser_id, int64 query_id)
+{
+	if (subscriptions == nullptr)
+		return;
+	for (auto it = subscriptions->begin(); it != subscriptions->end(); ++it) {
+		if (it->browser_id == browser_id && it->query_id == query_id) {
+			subscriptions->erase(it);
+			return;
+		}
+	}
+}
+
+class EventStreamHandler : public CefMessageRouterBrowserSide::Handler
+{
+public:
+
+	EventStreamHandler() : _subscribe_id(IdString64("stingray.subscribe").id()) {}
+
+	bool OnQuery(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame>, int64 query_id, const CefString& request, bool persistent,
+		CefRefPtr<Callback> callback) OVERRIDE
+	{
+		const auto* frame = request.c_str();
+		const size_t frame_size = request.length();
+		if (frame == nullptr || frame_size < QUERY_HEADER_SIZE || read_frame<uint64_t>(frame, 0) != _subscribe_id)
+			return false;
+
+		if (!persistent) {
+			callback->Failure(-1, "Event subscriptions must be persistent queries");
+			return true;
+		}
+
+		const unsigned topic_size = read_frame<unsigned>(frame, 8);
+		if (QUERY_HEADER_SIZE + (size_t)topic_size > frame_size) {
+			callback->Failure(-1, "Truncated query payload");
+			return true;
+		}
+
+		std::string topic(topic_size, '\0');
+		for (unsigned i = 0; i < topic_size; ++i)
+			topic[i] = (char)frame[QUERY_HEADER_SIZE + i];
+
+		EventSubscription subscription;
+		subscription.browser_id = browser->GetIdentifier();
+		subscription.query_id = query_id;
+		subscription.topic = IdString64(topic_size, topic.c_str()).id();
+		subscription.callback = callback;
+		subscription.dropped = 0;
+		WebApp::run_on_engine_thread([subscription]() {
+			if (subscriptions)
+				subscriptions->push_back(subscription);
+		});
+		return true;
+	}
+
+	void OnQueryCanceled(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame>, int64 query_id) OVERRIDE
+	{
+		const int browser_id = browser->GetIdentifier();
+		WebApp::run_on_engine_thread([browser_id, query_id]() { remove_subscription(browser_id, query_id); });
+	}
+
+private:
+
+	uint64_t _subscribe_id;
+};
+
+// Routers keep a pointer to the handler until their browser is released, so it lives as long as the plugin.
+static EventStreamHandler event_handler;
+
+void setup_event_streams()
+{
+	subscriptions = new std::vector<EventSubscription>();
+}
+
+void shutdown_event_streams()
+{
+	delete subscriptions;
+	subscriptions = nullptr;
+}
+
+CefMessageRouterBrowserSide::Handler* event_stream_handler()
+{
+	return &event_handler;
+}
+
+bool publish_event(const char* topic, const char* data, unsigned size)
+{
+	if (subscriptions == nullptr || subscriptions->empty())
+		return true;
+
+	bool queued = true;
+	const uint64_t topic_id = IdString64(topic).id();
+	for (auto& subscription : *subscriptions) {
+		if (subscription.topic != topic_id)
+			continue;
+
+		std::wstring& backlog = subscription.backlog;
+		if (backlog.size() + EVENT_HEADER_SIZE + size > event_backlog_bytes) {
+			subscription.dropped++;
+			queued = false;
+			continue;
+		}
+
+		for (unsigned i = 0; i < EVENT_HEADER_SIZE; ++i)
+			backlog.push_back((wchar_t)((size >> (i * 8)) & 0xFF));
+		for (unsigned i = 0; i < size; ++i)
+			backlog.push_back((unsigned char)data[i]);
+	}
+	return queued;
+}
+
+void flush_event_streams()
+{
+	if (subscriptions == nullptr)
+		return;
+
+	for (auto& subscription : *subscriptions) {
+		if (subscription.dropped > 0) {
+			stingray::api::log->warning("HTML5", stingray::api::error->eprintf("Event stream backlog full, dropped %u events.", subscription.dropped));
+			subscription.dropped = 0;
+		}
+
+		std::wstring& backlog = subscription.backlog;
+		if (backlog.empty())
+			continue;
+
+		if (backlog.size() <= event_batch_bytes) {
+			subscription.callback->Success(backlog);
+			backlog.clear();
+			continue;
+		}
+
+		// Send whole records up to the batch size, always at least one, the rest waits for the next frame.
+		size_t batch_size = 0;
+		while (batch_size < backlog.size()) {
+			const size_t record_size = EVENT_HEADER_SIZE + read_frame<unsigned>(backlog.c_str(), (unsigned)batch_size);
+			if (batch_size > 0 && batch_size + record_size > event_batch_bytes)
+				break;
+			batch_size += record_size;
+		}
+		subscription.callback->Success(backlog.substr(0, batch_size));
+		backlog.erase(0, batch_size);
+	}
+}
+
+void set_event_stream_limits(unsigned batch_bytes, unsigned backlog_bytes)
+{
+	event_batch_bytes = batch_bytes > 0 ? batch_bytes : 1;
+	event_backlog_bytes = backlog_bytes > event_batch_bytes ? backlog_bytes : event_batch_bytes;
+}
+
+} // end namespace
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <include/wrapper/cef_message_router.h>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Engine to page event streams.
+ *
+ * A page subscribes to a topic with a persistent `cefQuery` framed as described in `html5_web_view.h`,
+ * using the `IdString64("stingray.subscribe")` function id and the topic name as payload. Events
+ * published to the topic are queued and sent once per frame, as one response per subscription made of
+ * `[4-byte little-endian size][payload]` records. Canceling the query ends the subscription.
+ *
+ *   var query = cefQuery({ request: stingray.encodeQuery("stingray.subscribe", topic), persistent: true,
+ *       onSuccess: function (batch) { stingray.decodeEvents(batch).forEach(on_event); } });
+ */
+void setup_event_streams();
+void shutdown_event_streams();
+
+// Message router handler serving the subscriptions, shared by all web views and web apps.
+CefMessageRouterBrowserSide::Handler* event_stream_handler();
+
+// Queues an event for the topic subscribers. Returns false if a subscriber backlog is full and the event was dropped for it.
+bool publish_event(const char* topic, const char* data, unsigned size);
+void flush_event_streams();
+
+// Bytes sent to a subscription per frame, and bytes it can keep queued before new events are dropped.
+void set_event_stream_limits(unsigned batch_bytes, unsigned backlog_bytes);
+
+} // end namespace
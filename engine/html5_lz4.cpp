@@ -0,0 +1,257 @@
+#include "html5_lz4.h"
+
+#include <string.h>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+static const unsigned MIN_MATCH = 4;
+static const unsigned LAST_LITERALS = 5;
+static const unsigned MATCH_FIND_LIMIT = 12;
+static const unsigned MAX_OFFSET = 65535;
+static const unsigned HASH_BITS = 12;
+static const unsigned HC_HASH_BITS = 15;
+static const unsigned HC_MAX_ATTEMPTS = 64;
+
+static uint32_t read_u32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static unsigned hash_sequence(uint32_t sequence, unsigned bits = HASH_BITS)
+{
+	return (sequence * 2654435761u) >> (32 - bits);
+}
+
+// Writes sequences to the destination block, failing once the capacity is exceeded.
+class Lz4Writer
+{
+public:
+
+	Lz4Writer(uint8_t* dest, unsigned capacity) : _op(dest), _end(dest + capacity), _ok(true) {}
+
+	bool ok() const { return _ok; }
+	uint8_t* position() const { return _op; }
+
+	void write_sequence(const uint8_t* literals, unsigned literal_length, unsigned offset, unsigned match_length)
+	{
+		uint8_t* token = reserve(1);
+		if (!token)
+			return;
+
+		*token = (uint8_t)((literal_length < 15 ? literal_length : 15) << 4);
+		if (literal_length >= 15)
+			write_length(literal_length - 15);
+
+		uint8_t* op = reserve(literal_length);
+		if (!op)
+			return;
+		memcpy(op, literals, literal_length);
+
+		// The last sequence only has literals.
+		if (match_length == 0)
+			return;
+
+		op = reserve(2);
+		if (!op)
+			return;
+		op[0] = (uint8_t)(offset & 0xFF);
+		op[1] = (uint8_t)(offset >> 8);
+
+		const unsigned length = match_length - MIN_MATCH;
+		*token |= (uint8_t)(length < 15 ? length : 15);
+		if (length >= 15)
+			write_length(length - 15);
+	}
+
+private:
+
+	uint8_t* reserve(unsigned size)
+	{
+		if (!_ok || (unsigned)(_end - _op) < size) {
+			_ok = false;
+			return nullptr;
+		}
+		uint8_t* op = _op;
+		_op += size;
+		return op;
+	}
+
+	void write_length(unsigned length)
+	{
+		for (; length >= 255; length -= 255) {
+			if (uint8_t* op = reserve(1))
+				*op = 255;
+		}
+		if (uint8_t* op = reserve(1))
+			*op = (uint8_t)length;
+	}
+
+	uint8_t* _op;
+	uint8_t* _end;
+	bool _ok;
+};
+
+unsigned lz4_compress_block(const uint8_t* source, unsigned size, uint8_t* dest, unsigned capacity)
+{
+	Lz4Writer writer(dest, capacity);
+	unsigned anchor = 0;
+
+	if (size > MATCH_FIND_LIMIT) {
+		// Positions are stored plus one, so zero means empty.
+		unsigned table[1 << HASH_BITS];
+		memset(table, 0, sizeof(table));
+
+		const unsigned match_start_limit = size - MATCH_FIND_LIMIT;
+		const unsigned match_end_limit = size - LAST_LITERALS;
+		unsigned ip = 0;
+		while (ip < match_start_limit) {
+			const uint32_t sequence = read_u32(source + ip);
+			const unsigned h = hash_sequence(sequence);
+			const unsigned candidate = table[h];
+			table[h] = ip + 1;
+
+			if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || read_u32(source + candidate - 1) != sequence) {
+				++ip;
+				continue;
+			}
+
+			const unsigned match = candidate - 1;
+			unsigned match_length = MIN_MATCH;
+			while (ip + match_length < match_end_limit && source[match + match_length] == source[ip + match_length])
+				++match_length;
+
+			writer.write_sequence(source + anchor, ip - anchor, ip - match, match_length);
+			if (!writer.ok())
+				return 0;
+
+			ip += match_length;
+			anchor = ip;
+		}
+	}
+
+	writer.write_sequence(source + anchor, size - anchor, 0, 0);
+	return writer.ok() ? (unsigned)(writer.position() - dest) : 0;
+}
+
+unsigned lz4_compress_block_hc(const uint8_t* source, unsigned size, uint8_t* dest, unsigned capacity)
+{
+	Lz4Writer writer(dest, capacity);
+	unsigned anchor = 0;
+
+	if (size > MATCH_FIND_LIMIT) {
+		// Positions are stored plus one, so zero means empty. Each position links to the previous one with the same hash.
+		std::vector<unsigned> head(1 << HC_HASH_BITS, 0);
+		std::vector<unsigned> chain(size, 0);
+		unsigned next_insert = 0;
+
+		const unsigned match_start_limit = size - MATCH_FIND_LIMIT;
+		const unsigned match_end_limit = size - LAST_LITERALS;
+		unsigned ip = 0;
+		while (ip < match_start_limit) {
+			// Positions covered by the last match are inserted too, so later matches can refer to them.
+			for (; next_insert <= ip; ++next_insert) {
+				const unsigned h = hash_sequence(read_u32(source + next_insert), HC_HASH_BITS);
+				chain[next_insert] = head[h];
+				head[h] = next_insert + 1;
+			}
+
+			const uint32_t sequence = read_u32(source + ip);
+			unsigned best_match = 0, best_length = 0;
+			unsigned candidate = chain[ip];
+			for (unsigned attempts = 0; candidate != 0 && attempts < HC_MAX_ATTEMPTS; ++attempts) {
+				const unsigned match = candidate - 1;
+				if (ip - match > MAX_OFFSET)
+					break;
+				if (read_u32(source + match) == sequence) {
+					unsigned match_length = MIN_MATCH;
+					while (ip + match_length < match_end_limit && source[match + match_length] == source[ip + match_length])
+						++match_length;
+					if (match_length > best_length) {
+						best_length = match_length;
+						best_match = match;
+					}
+				}
+				candidate = chain[match];
+			}
+
+			if (best_length == 0) {
+				++ip;
+				continue;
+			}
+
+			writer.write_sequence(source + anchor, ip - anchor, ip - best_match, best_length);
+			if (!writer.ok())
+				return 0;
+
+			ip += best_length;
+			anchor = ip;
+		}
+	}
+
+	writer.write_sequence(source + anchor, size - anchor, 0, 0);
+	return writer.ok() ? (unsigned)(writer.position() - dest) : 0;
+}
+
+static bool read_length(const uint8_t*& ip, const uint8_t* end, unsigned& length)
+{
+	uint8_t b;
+	do {
+		if (ip >= end)
+			return false;
+		b = *ip++;
+		length += b;
+	} while (b == 255);
+	return true;
+}
+
+bool lz4_decompress_block(const uint8_t* source, unsigned source_size, uint8_t* dest, unsigned size)
+{
+	const uint8_t* ip = source;
+	const uint8_t* const ip_end = source + source_size;
+	uint8_t* op = dest;
+	uint8_t* const op_end = dest + size;
+
+	while (ip < ip_end) {
+		const unsigned token = *ip++;
+
+		unsigned literal_length = token >> 4;
+		if (literal_length == 15 && !read_length(ip, ip_end, literal_length))
+			return false;
+		if ((unsigned)(ip_end - ip) < literal_length || (unsigned)(op_end - op) < literal_length)
+			return false;
+		memcpy(op, ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		// The last sequence ends after its literals.
+		if (ip == ip_end)
+			break;
+
+		if (ip_end - ip < 2)
+			return false;
+		const unsigned offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (unsigned)(op - dest))
+			return false;
+
+		unsigned match_length = token & 15;
+		if (match_length == 15 && !read_length(ip, ip_end, match_length))
+			return false;
+		match_length += MIN_MATCH;
+		if ((unsigned)(op_end - op) < match_length)
+			return false;
+
+		// Matches can overlap the bytes they produce, so copy forward one byte at a time.
+		const uint8_t* match = op - offset;
+		for (unsigned i = 0; i < match_length; ++i)
+			op[i] = match[i];
+		op += match_length;
+	}
+
+	return op == op_end;
+}
+
+} // end namespace
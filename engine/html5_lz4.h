@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * LZ4 block format codec used to store compressed web page resources.
+ *
+ * Blocks are independent, so resources can be compressed and decoded one block at a time.
+ */
+
+// Maximum compressed size of a block of `size` bytes.
+inline unsigned lz4_compress_bound(unsigned size) { return size + size / 255 + 16; }
+
+// Compresses a block, returns the compressed size or 0 if it does not fit in `capacity`.
+unsigned lz4_compress_block(const uint8_t* source, unsigned size, uint8_t* dest, unsigned capacity);
+
+// Same as lz4_compress_block, but searches hash chains for the longest match. Slower to compress,
+// smaller output and the same decoding cost.
+unsigned lz4_compress_block_hc(const uint8_t* source, unsigned size, uint8_t* dest, unsigned capacity);
+
+// Decompresses a block to exactly `size` bytes, returns false if the block is malformed.
+bool lz4_decompress_block(const uint8_t* source, unsigned source_size, uint8_t* dest, unsigned size);
+
+} // end namespace
@@ -0,0 +1,293 @@
+#include "html5_mime_types.h"
+
+#include <string.h>
+
+namespace PLUGIN_NAMESPACE {
+
+const char DEFAULT_MIME_TYPE[] = "application/octet-stream";
+
+// Longest extension the built-in table holds, longer ones are never looked up.
+static const unsigned MAX_EXTENSION_SIZE = 15;
+
+// The table is a perfect hash, every extension has its own slot for this seed.
+// Pick a new seed if an extension is added and two of them end up in the same slot.
+static const unsigned MIME_TYPE_HASH_SEED = 20625;
+static const unsigned MIME_TYPE_HASH_BITS = 6;
+
+// Built-in types by slot, see `hash_extension`.
+static const MimeTypeEntry BUILTIN_MIME_TYPES[1 << MIME_TYPE_HASH_BITS] = {
+	{ "csv", "text/csv" },
+	{ "json", "application/json" },
+	{ "pdf", "application/pdf" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "htm", "text/html" },
+	{ nullptr, nullptr },
+	{ "jpg", "image/jpeg" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "wasm", "application/wasm" },
+	{ "svg", "image/svg+xml" },
+	{ "zip", "application/zip" },
+	{ nullptr, nullptr },
+	{ "gif", "image/gif" },
+	{ nullptr, nullptr },
+	{ "txt", "text/plain" },
+	{ nullptr, nullptr },
+	{ "xml", "text/xml" },
+	{ nullptr, nullptr },
+	{ "ttf", "font/ttf" },
+	{ nullptr, nullptr },
+	{ "woff", "font/woff" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "jpeg", "image/jpeg" },
+	{ nullptr, nullptr },
+	{ "eot", "application/vnd.ms-fontobject" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "ico", "image/x-icon" },
+	{ nullptr, nullptr },
+	{ "wav", "audio/wav" },
+	{ nullptr, nullptr },
+	{ "mp3", "audio/mpeg" },
+	{ "mp4", "video/mp4" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "bmp", "image/bmp" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "otf", "font/otf" },
+	{ nullptr, nullptr },
+	{ "woff2", "font/woff2" },
+	{ "html", "text/html" },
+	{ "ogg", "audio/ogg" },
+	{ nullptr, nullptr },
+	{ "js", "application/javascript" },
+	{ nullptr, nullptr },
+	{ "mjs", "application/javascript" },
+	{ nullptr, nullptr },
+	{ "png", "image/png" },
+	{ "md", "text/markdown" },
+	{ "webm", "video/webm" },
+	{ "webp", "image/webp" },
+	{ nullptr, nullptr },
+	{ "map", "application/json" },
+	{ nullptr, nullptr },
+	{ nullptr, nullptr },
+	{ "css", "text/css" },
+};
+
+// FNV-1a of the lowercase extension, the top bits select the slot.
+static unsigned hash_extension(const char* extension, unsigned size)
+{
+	unsigned hash = 2166136261u ^ MIME_TYPE_HASH_SEED;
+	for (unsigned i = 0; i < size; ++i) {
+		hash ^= (unsigned char)extension[i];
+		hash *= 16777619u;
+	}
+	return hash >> (32 - MIME_TYPE_HASH_BITS);
+}
+
+static char to_lower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+}
+
+static bool is_identifier(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+// Compares an extension with a lowercase one, ignoring the case of the first.
+static bool equal_extension(const char* extension, unsigned size, const char* lowercase)
+{
+	for (unsigned i = 0; i < size; ++i) {
+		if (to_lower(extension[i]) != lowercase[i])
+			return false;
+	}
+	return lowercase[size] == '\0';
+}
+
+const char* find_builtin_mime_type(const char* extension, unsigned size)
+{
+	if (size > 0 && extension[0] == '.') {
+		++extension;
+		--size;
+	}
+	if (size == 0 || size > MAX_EXTENSION_SIZE)
+		return nullptr;
+
+	char lowercase[MAX_EXTENSION_SIZE];
+	for (unsigned i = 0; i < size; ++i)
+		lowercase[i] = to_lower(extension[i]);
+
+	const MimeTypeEntry& slot = BUILTIN_MIME_TYPES[hash_extension(lowercase, size)];
+	if (slot.extension && equal_extension(lowercase, size, slot.extension))
+		return slot.mime_type;
+	return nullptr;
+}
+
+const char* resolve_mime_type(const char* path, unsigned size, const MimeTypeEntry* overrides, unsigned override_count)
+{
+	// The extension starts after the last dot of the file name.
+	unsigned start = size;
+	while (start > 0 && path[start - 1] != '.' && path[start - 1] != '/' && path[start - 1] != '\\')
+		--start;
+	if (start == 0 || path[start - 1] != '.')
+		return DEFAULT_MIME_TYPE;
+
+	const char* extension = path + start;
+	const unsigned extension_size = size - start;
+	for (unsigned i = 0; i < override_count; ++i) {
+		if (equal_extension(extension, extension_size, overrides[i].extension))
+			return overrides[i].mime_type;
+	}
+
+	const char* mime_type = find_builtin_mime_type(extension, extension_size);
+	return mime_type ? mime_type : DEFAULT_MIME_TYPE;
+}
+
+// Minimal reader of the SJSON subset the overrides use: keys, quoted strings, objects and line comments.
+class SettingsReader
+{
+public:
+
+	SettingsReader(char* data, unsigned size) : _begin(data), _p(data), _end(data + size) {}
+
+	char peek() const { return _p < _end ? *_p : '\0'; }
+
+	void skip_space()
+	{
+		while (_p < _end) {
+			if (is_space(*_p)) {
+				++_p;
+			} else if (*_p == '/' && _p + 1 < _end && _p[1] == '/') {
+				while (_p < _end && *_p != '\n')
+					++_p;
+			} else {
+				break;
+			}
+		}
+	}
+
+	// Reads a bare or quoted key, `key_end` is where its null terminator can go once the value is read.
+	char* read_key(char*& key_end)
+	{
+		if (peek() == '"')
+			return read_string(key_end);
+		char* key = _p;
+		while (_p < _end && is_identifier(*_p))
+			++_p;
+		key_end = _p;
+		return _p > key ? key : nullptr;
+	}
+
+	char* read_string(char*& string_end)
+	{
+		if (peek() != '"')
+			return nullptr;
+		char* string = ++_p;
+		while (_p < _end && *_p != '"' && *_p != '\n')
+			++_p;
+		if (peek() != '"')
+			return nullptr;
+		string_end = _p++;
+		return string;
+	}
+
+	bool read_separator()
+	{
+		skip_space();
+		if (peek() != '=' && peek() != ':')
+			return false;
+		++_p;
+		skip_space();
+		return true;
+	}
+
+	// Moves past the `name = {` of a top level or nested object, returns false if the settings do not have it.
+	bool find_object(const char* name)
+	{
+		const unsigned name_size = (unsigned)strlen(name);
+		while ((unsigned)(_end - _p) >= name_size) {
+			// Names in comments and strings do not count.
+			if (*_p == '/' && _p[1] == '/') {
+				skip_space();
+				continue;
+			}
+			if (*_p == '"') {
+				char* string_end = nullptr;
+				if (!read_string(string_end))
+					++_p;
+				continue;
+			}
+
+			const bool starts_key = _p == _begin || !is_identifier(_p[-1]);
+			const bool ends_key = (unsigned)(_end - _p) == name_size || !is_identifier(_p[name_size]);
+			if (starts_key && ends_key && memcmp(_p, name, name_size) == 0) {
+				_p += name_size;
+				if (read_separator() && peek() == '{') {
+					++_p;
+					return true;
+				}
+			} else {
+				++_p;
+			}
+		}
+		return false;
+	}
+
+private:
+
+	char* _begin;
+	char* _p;
+	char* _end;
+};
+
+unsigned parse_mime_type_overrides(char* settings, unsigned size, MimeTypeEntry* overrides, unsigned capacity)
+{
+	SettingsReader reader(settings, size);
+	if (!reader.find_object("html5_mime_types"))
+		return 0;
+
+	unsigned count = 0;
+	while (count < capacity) {
+		reader.skip_space();
+		if (reader.peek() == '}')
+			break;
+
+		char* extension_end = nullptr;
+		char* extension = reader.read_key(extension_end);
+		if (!extension || !reader.read_separator())
+			break;
+		char* mime_type_end = nullptr;
+		char* mime_type = reader.read_string(mime_type_end);
+		if (!mime_type)
+			break;
+
+		// Both strings have been read past, so their terminators can be written in place.
+		*extension_end = '\0';
+		*mime_type_end = '\0';
+		if (extension[0] == '.')
+			++extension;
+		for (char* c = extension; *c; ++c)
+			*c = to_lower(*c);
+
+		overrides[count].extension = extension;
+		overrides[count].mime_type = mime_type;
+		++count;
+	}
+	return count;
+}
+
+} // end namespace
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Extension to MIME type resolution for compiled web pages.
+ *
+ * Known extensions are resolved from a built-in table, so compiled pages do not depend on the
+ * machine that compiled them. Projects can add or replace types with overrides.
+ */
+
+// Extension to MIME type pair, extensions are lowercase and without the leading dot.
+struct MimeTypeEntry
+{
+	const char* extension;
+	const char* mime_type;
+};
+
+// Type of extensions that neither the table nor the overrides know.
+extern const char DEFAULT_MIME_TYPE[];
+
+// Returns the built-in MIME type of an extension of `size` bytes, with or without its leading dot, or nullptr if unknown.
+const char* find_builtin_mime_type(const char* extension, unsigned size);
+
+// Returns the MIME type of a resource path, looking at the overrides first and then the built-in table.
+const char* resolve_mime_type(const char* path, unsigned size, const MimeTypeEntry* overrides, unsigned override_count);
+
+/**
+ * Parses the `html5_mime_types = { ext = "type" ... }` object of a settings file in place, strings of
+ * `settings` are null terminated and lowercased where needed. Returns the number of overrides written,
+ * at most `capacity`.
+ */
+unsigned parse_mime_type_overrides(char* settings, unsigned size, MimeTypeEntry* overrides, unsigned capacity);
+
+} // end namespace
@@ -1,6 +1,8 @@
 
 #include "html5_web_app.h"
 #include "html5_api.h"
+#include "html5_event_stream.h"
+#include "html5_resource_loader.h"
 #include "html5_web_browser.h"
 #include "html5_web_page.h"
 
@@ -11,6 +13,7 @@
 
 #define DEFINE_STINGRAY_API 1
 #include "stingray_api.h"
+#include "html5_api_profiler.h"
 
 namespace PLUGIN_NAMESPACE {
 
@@ -46,6 +49,7 @@ void setup_plugin(GetApiFunction get_engine_api)
 	stingray::api::resource_manager = (ResourceManagerApi*)get_engine_api(RESOURCE_MANAGER_API_ID);
 	stingray::api::thread = (ThreadApi*)get_engine_api(THREAD_API_ID);
 	stingray::api::profiler = (ProfilerApi*)get_engine_api(PROFILER_API_ID);
+	stingray::api::timer = (TimerApi*)get_engine_api(TIMER_API_ID);
 }
 
 /**
@@ -76,6 +80,10 @@ void setup_runtime_plugin(GetApiFunction get_engine_api)
 	stingray::api::renderer = (RenderInterfaceApi*)get_engine_api(RENDER_INTERFACE_API_ID);
 	stingray::api::unit_reference = (UnitReferenceApi*)get_engine_api(UNIT_REFERENCE_API_ID);
 
+	setup_api_profiler();
+	setup_sync();
+	setup_event_streams();
+
 	// Create main web app.
 	web_app = WebApp::init();
 
@@ -83,6 +91,7 @@ void setup_runtime_plugin(GetApiFunction get_engine_api)
 	load_lua_api(stingray::api::lua);
 
 	setup_web_page_database();
+	setup_resource_loader();
 
 	// Initialize modules
 	browser::init();
@@ -115,6 +124,18 @@ void units_unspawned(CApiUnit **units, unsigned count)
  */
 void update_plugin(float dt)
 {
+	// Apply the writes pages queued during the last frame before the engine frame updates.
+	end_pipelined_sync();
+
+	// Run the `stingray.async` calls queued by pages while the engine waits.
+	flush_async_api_calls();
+
+	// Send the events published last frame, the message pump delivers them.
+	flush_event_streams();
+
+	// Load the pages requests wait for before the message pump serves them.
+	update_web_pages();
+
 	WebApp::update();
 }
 
@@ -136,6 +157,19 @@ void unload_resources()
 	unload_common_plugin_resources();
 }
 
+/**
+ * Hot-reload compiled web pages.
+ */
+int can_refresh(uint64_t type)
+{
+	return can_refresh_web_pages(type);
+}
+
+void refresh(uint64_t type, uint64_t name)
+{
+	refresh_web_page(name);
+}
+
 /**
  * Initialize the HTMl5 content compiler.
  */
@@ -162,10 +196,17 @@ void shutdown_data_compiler()
  */
 void unload_plugin()
 {
+	end_pipelined_sync();
 	browser::shutdown();
 	unload_lua_api(stingray::api::lua);
+	// CEF threads still serve requests until WebApp::shutdown, the loader and the page database wait for the
+	// ones in progress and answer later ones without their data.
+	shutdown_resource_loader();
 	shutdown_web_page_database();
+	shutdown_event_streams();
 	WebApp::shutdown();
+	shutdown_sync();
+	shutdown_api_profiler();
 
 	unload_common_plugin_resources();
 }
@@ -188,6 +229,8 @@ extern "C" PLUGIN_DLLEXPORT void *get_plugin_api(unsigned api_id)
 		plugin_api.units_unspawned = units_unspawned;
 		plugin_api.setup_resources = setup_resources;
 		plugin_api.shutdown_resources = unload_resources;
+		plugin_api.can_refresh = can_refresh;
+		plugin_api.refresh = refresh;
 		plugin_api.setup_data_compiler = setup_data_compiler;
 		plugin_api.shutdown_data_compiler = shutdown_data_compiler;
 		plugin_api.shutdown_game = unload_plugin;
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Read-mostly value published to lock-free readers.
+ *
+ * Readers enter a `ReadSection` and read the published value without locking. Writers, serialized by the caller,
+ * publish a modified copy and retire the previous value. Retired values are freed after a grace period: readers are
+ * counted in one of two slots by epoch, and the epoch only advances once the readers of the slot it reuses have
+ * left. A value retired in epoch `e` can't be read anymore once the epoch reached `e + 2`, so it is freed by the
+ * next reader leaving or writer publishing, even while readers keep overlapping.
+ */
+template <class T>
+class ReadMostly
+{
+public:
+
+	typedef std::function<void(T*)> Deleter;
+
+	ReadMostly(T* value, Deleter deleter) : _value(value), _deleter(deleter), _epoch(0), _retired(nullptr), _retired_count(0)
+	{
+		_readers[0] = 0;
+		_readers[1] = 0;
+	}
+
+	// No reader may be left.
+	~ReadMostly()
+	{
+		Retired* retired = _retired.exchange(nullptr);
+		while (retired) {
+			Retired* next = retired->next;
+			_deleter(retired->value);
+			delete retired;
+			retired = next;
+		}
+		_deleter(_value.load());
+	}
+
+	class ReadSection
+	{
+	public:
+
+		explicit ReadSection(ReadMostly& owner) : _owner(owner)
+		{
+			// Counted in the slot of the epoch still current after counting, so a writer advancing the epoch
+			// sees this reader in the slot it checks.
+			for (;;) {
+				_epoch = owner._epoch.load();
+				++owner._readers[_epoch & 1];
+				if (owner._epoch.load() == _epoch)
+					break;
+				--owner._readers[_epoch & 1];
+			}
+			_value = owner._value.load();
+		}
+
+		~ReadSection()
+		{
+			--_owner._readers[_epoch & 1];
+			_owner.reclaim();
+		}
+
+		const T* operator->() const { return _value; }
+		const T& operator*() const { return *_value; }
+
+	private:
+
+		ReadSection(const ReadSection&) = delete;
+		ReadSection& operator=(const ReadSection&) = delete;
+
+		ReadMostly& _owner;
+		unsigned _epoch;
+		const T* _value;
+	};
+
+	// Writer side, called by one writer at a time.
+
+	const T* get() const { return _value.load(); }
+
+	void publish(T* value)
+	{
+		Retired* retired = new Retired();
+		retired->value = _value.exchange(value);
+		retired->epoch = _epoch.load();
+		++_retired_count;
+		push(retired, retired);
+		reclaim();
+	}
+
+	// Advances the epoch if the readers of the slot it reuses are gone and frees the values retired two epochs
+	// before, safe to call from any thread.
+	void reclaim()
+	{
+		if (_retired.load() == nullptr)
+			return;
+
+		unsigned epoch = _epoch.load();
+		if (_readers[(epoch + 1) & 1].load() == 0)
+			_epoch.compare_exchange_strong(epoch, epoch + 1);
+
+		// Take the whole list, reclaiming threads never share a value, and put back what is still too recent.
+		// The epoch is read after taking the list, values retired meanwhile are never newer than it.
+		Retired* retired = _retired.exchange(nullptr);
+		epoch = _epoch.load();
+		Retired* kept = nullptr;
+		Retired* kept_last = nullptr;
+		while (retired) {
+			Retired* next = retired->next;
+			if (epoch - retired->epoch >= 2) {
+				_deleter(retired->value);
+				delete retired;
+				--_retired_count;
+			} else {
+				retired->next = kept;
+				kept = retired;
+				if (kept_last == nullptr)
+					kept_last = retired;
+			}
+			retired = next;
+		}
+		if (kept)
+			push(kept, kept_last);
+	}
+
+	// Number of values retired and not freed yet
+	unsigned retired_count() const { return _retired_count.load(); }
+
+private:
+
+	struct Retired
+	{
+		T* value;
+		unsigned epoch;
+		Retired* next;
+	};
+
+	// Pushes the list from first to last, lists are only ever taken whole, so there is no ABA.
+	void push(Retired* first, Retired* last)
+	{
+		Retired* head = _retired.load();
+		do {
+			last->next = head;
+		} while (!_retired.compare_exchange_weak(head, first));
+	}
+
+	ReadMostly(const ReadMostly&) = delete;
+	ReadMostly& operator=(const ReadMostly&) = delete;
+
+	std::atomic<T*> _value;
+	Deleter _deleter;
+	std::atomic<unsigned> _epoch;
+	std::atomic<unsigned> _readers[2];
+	std::atomic<Retired*> _retired;
+	std::atomic<unsigned> _retired_count;
+};
+
+} // end namespace
@@ -0,0 +1,93 @@
+#include "html5_resource_loader.h"
+
+#include "stingray_api.h"
+
+#include <atomic>
+#include <thread>
+
+namespace PLUGIN_NAMESPACE {
+
+// Queues the loader drains, published to the queuing threads while the loader runs
+static TaskQueue* loader_tasks = nullptr;
+static TaskQueue* loader_background_tasks = nullptr;
+static std::atomic<TaskQueue*> resource_tasks(nullptr);
+static std::atomic<TaskQueue*> background_resource_tasks(nullptr);
+static std::atomic<int> queuing_threads(0);
+static ThreadEvent* resource_tasks_event = nullptr;
+static ThreadID resource_loader_thread = nullptr;
+static std::atomic<bool> resource_loader_running(false);
+
+static void resource_loader_entry(void*)
+{
+	while (resource_loader_running.load()) {
+		stingray::api::thread->wait_for_event(resource_tasks_event);
+
+		// Requests come first, background tasks run one at a time while none is waiting.
+		do {
+			loader_tasks->drain();
+		} while (resource_loader_running.load() && loader_background_tasks->run_one());
+	}
+}
+
+void setup_resource_loader()
+{
+	loader_tasks = new TaskQueue();
+	loader_background_tasks = new TaskQueue();
+	resource_tasks_event = stingray::api::thread->create_event(stingray::api::allocator_object, 0, 0, "HTML5 resource tasks");
+	resource_loader_running = true;
+	resource_loader_thread = stingray::api::thread->create_thread("HTML5 resource loader", resource_loader_entry, nullptr, 0);
+	resource_tasks = loader_tasks;
+	background_resource_tasks = loader_background_tasks;
+}
+
+void shutdown_resource_loader()
+{
+	if (resource_loader_thread == nullptr)
+		return;
+
+	// CEF threads may still queue tasks, the ones that found the queue finish pushing before it goes away.
+	resource_tasks = nullptr;
+	background_resource_tasks = nullptr;
+	while (queuing_threads > 0)
+		std::this_thread::yield();
+
+	resource_loader_running = false;
+	stingray::api::thread->set_event(resource_tasks_event);
+	stingray::api::thread->wait_for_thread(resource_loader_thread);
+	resource_loader_thread = nullptr;
+
+	// Tasks queued after the last drain belong to requests CEF cancels on shutdown.
+	delete loader_tasks;
+	loader_tasks = nullptr;
+	delete loader_background_tasks;
+	loader_background_tasks = nullptr;
+	stingray::api::thread->destroy_event(resource_tasks_event, stingray::api::allocator_object);
+	resource_tasks_event = nullptr;
+}
+
+static void queue_task(std::atomic<TaskQueue*>& queue, TaskQueue::Task task)
+{
+	// Count the thread before loading the queue, so shutdown can't delete it in between.
+	queuing_threads++;
+	TaskQueue* tasks = queue.load();
+	if (tasks) {
+		tasks->push(std::move(task));
+		stingray::api::thread->set_event(resource_tasks_event);
+	}
+	queuing_threads--;
+
+	if (!tasks)
+		task();
+}
+
+void queue_resource_task(TaskQueue::Task task)
+{
+	queue_task(resource_tasks, std::move(task));
+}
+
+void queue_background_resource_task(TaskQueue::Task task)
+{
+	queue_task(background_resource_tasks, std::move(task));
+}
+
+} // end namespace
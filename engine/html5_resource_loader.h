@@ -0,0 +1,22 @@
+#pragma once
+
+#include "html5_task_queue.h"
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Worker thread serving stingray:// resources, so page lookups and block decoding do not hold CEF's IO thread.
+ */
+
+void setup_resource_loader();
+
+void shutdown_resource_loader();
+
+// Runs the task on the resource loader thread, or right away once the loader is shut down.
+void queue_resource_task(TaskQueue::Task task);
+
+// Runs the task on the resource loader thread when no queued request is waiting, or right away once the loader is
+// shut down. Background tasks run one at a time in queue order, requests queued meanwhile go first.
+void queue_background_resource_task(TaskQueue::Task task);
+
+} // end namespace
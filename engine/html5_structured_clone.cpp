@@ -0,0 +1,258 @@
+#include "html5_structured_clone.h"
+
+#include "stingray_api.h"
+
+#include <string.h>
+
+namespace PLUGIN_NAMESPACE {
+
+// Lua 5.1 value types returned by `LuaApi::type`.
+enum LuaType
+{
+	LUA_TYPE_NIL = 0,
+	LUA_TYPE_BOOLEAN = 1,
+	LUA_TYPE_NUMBER = 3,
+	LUA_TYPE_STRING = 4,
+	LUA_TYPE_TABLE = 5
+};
+
+// Bounds the recursion, tables referencing themselves would never end.
+static const unsigned MAX_CLONE_DEPTH = 64;
+
+static void write_tag(std::vector<char>& buffer, StructuredCloneTag tag)
+{
+	buffer.push_back((char)tag);
+}
+
+static void write_u32(std::vector<char>& buffer, unsigned value)
+{
+	for (unsigned i = 0; i < 4; ++i)
+		buffer.push_back((char)((value >> (i * 8)) & 0xFF));
+}
+
+static void patch_u32(std::vector<char>& buffer, size_t offset, unsigned value)
+{
+	for (unsigned i = 0; i < 4; ++i)
+		buffer[offset + i] = (char)((value >> (i * 8)) & 0xFF);
+}
+
+static void write_number(std::vector<char>& buffer, double value)
+{
+	const size_t offset = buffer.size();
+	buffer.resize(offset + sizeof(double));
+	memcpy(&buffer[offset], &value, sizeof(double));
+}
+
+static void write_string(std::vector<char>& buffer, const char* s, size_t size)
+{
+	write_u32(buffer, (unsigned)size);
+	buffer.insert(buffer.end(), s, s + size);
+}
+
+// Writes a table key as a string, without `tolstring` which would convert the key in place and break `next`.
+static void write_key(lua_State* L, int index, std::vector<char>& buffer)
+{
+	auto lua = stingray::api::lua;
+	if (lua->type(L, index) == LUA_TYPE_NUMBER) {
+		char key[32];
+		const int size = sprintf(key, "%.14g", lua->tonumber(L, index));
+		write_string(buffer, key, size);
+	} else {
+		size_t size = 0;
+		const char* key = lua->tolstring(L, index, &size);
+		write_string(buffer, key, size);
+	}
+}
+
+static bool write_lua_value(lua_State* L, int index, std::vector<char>& buffer, unsigned depth);
+
+static bool write_lua_table(lua_State* L, int index, std::vector<char>& buffer, unsigned depth)
+{
+	auto lua = stingray::api::lua;
+	if (depth >= MAX_CLONE_DEPTH || !lua->checkstack(L, 3))
+		return false;
+
+	// Tables with only the keys 1..n are arrays, all others objects.
+	const unsigned length = (unsigned)lua->objlen(L, index);
+	unsigned count = 0;
+	lua->pushnil(L);
+	while (lua->next(L, index)) {
+		++count;
+		lua->settop(L, -2);
+	}
+
+	if (length > 0 && count == length) {
+		write_tag(buffer, CLONE_ARRAY);
+		write_u32(buffer, length);
+		for (unsigned i = 1; i <= length; ++i) {
+			lua->rawgeti(L, index, i);
+			const bool written = write_lua_value(L, lua->gettop(L), buffer, depth + 1);
+			lua->settop(L, -2);
+			if (!written)
+				return false;
+		}
+		return true;
+	}
+
+	write_tag(buffer, CLONE_OBJECT);
+	write_u32(buffer, count);
+	lua->pushnil(L);
+	while (lua->next(L, index)) {
+		const int key_type = lua->type(L, -2);
+		if (key_type != LUA_TYPE_STRING && key_type != LUA_TYPE_NUMBER) {
+			lua->settop(L, -3);
+			return false;
+		}
+		write_key(L, lua->gettop(L) - 1, buffer);
+		if (!write_lua_value(L, lua->gettop(L), buffer, depth + 1)) {
+			lua->settop(L, -3);
+			return false;
+		}
+		lua->settop(L, -2);
+	}
+	return true;
+}
+
+static bool write_lua_value(lua_State* L, int index, std::vector<char>& buffer, unsigned depth)
+{
+	auto lua = stingray::api::lua;
+	switch (lua->type(L, index)) {
+		case LUA_TYPE_NIL:
+			write_tag(buffer, CLONE_NULL);
+			return true;
+		case LUA_TYPE_BOOLEAN:
+			write_tag(buffer, lua->toboolean(L, index) ? CLONE_TRUE : CLONE_FALSE);
+			return true;
+		case LUA_TYPE_NUMBER:
+			write_tag(buffer, CLONE_NUMBER);
+			write_number(buffer, lua->tonumber(L, index));
+			return true;
+		case LUA_TYPE_STRING: {
+			size_t size = 0;
+			const char* s = lua->tolstring(L, index, &size);
+			write_tag(buffer, CLONE_STRING);
+			write_string(buffer, s, size);
+			return true;
+		}
+		case LUA_TYPE_TABLE:
+			return write_lua_table(L, index, buffer, depth);
+		default:
+			return false;
+	}
+}
+
+bool clone_lua_value(lua_State* L, int index, std::vector<char>& buffer)
+{
+	if (index < 0)
+		index = stingray::api::lua->gettop(L) + index + 1;
+	const size_t start = buffer.size();
+	if (write_lua_value(L, index, buffer, 0))
+		return true;
+	buffer.resize(start);
+	return false;
+}
+
+// Reads a cloned buffer, every read is bounds checked since the buffer comes from another process.
+class CloneReader
+{
+public:
+
+	CloneReader(const char* data, size_t size) : _data(data), _end(data + size) {}
+
+	bool done() const { return _data == _end; }
+
+	bool read_u32(unsigned& value)
+	{
+		if (_end - _data < 4)
+			return false;
+		value = 0;
+		for (unsigned i = 0; i < 4; ++i)
+			value |= (unsigned)(unsigned char)_data[i] << (i * 8);
+		_data += 4;
+		return true;
+	}
+
+	bool read_string(CefString& value)
+	{
+		unsigned size = 0;
+		if (!read_u32(size) || (size_t)(_end - _data) < size)
+			return false;
+		value.FromString(std::string(_data, size));
+		_data += size;
+		return true;
+	}
+
+	CefRefPtr<CefV8Value> read_value(unsigned depth)
+	{
+		if (_data == _end || depth >= MAX_CLONE_DEPTH)
+			return nullptr;
+
+		switch ((StructuredCloneTag)*_data++) {
+			case CLONE_NULL:
+				return CefV8Value::CreateNull();
+			case CLONE_FALSE:
+				return CefV8Value::CreateBool(false);
+			case CLONE_TRUE:
+				return CefV8Value::CreateBool(true);
+			case CLONE_NUMBER: {
+				double value;
+				if ((size_t)(_end - _data) < sizeof(double))
+					return nullptr;
+				memcpy(&value, _data, sizeof(double));
+				_data += sizeof(double);
+				return CefV8Value::CreateDouble(value);
+			}
+			case CLONE_STRING: {
+				CefString value;
+				if (!read_string(value))
+					return nullptr;
+				return CefV8Value::CreateString(value);
+			}
+			case CLONE_ARRAY: {
+				unsigned length = 0;
+				if (!read_u32(length) || (size_t)(_end - _data) < length)
+					return nullptr;
+				auto array = CefV8Value::CreateArray((int)length);
+				for (unsigned i = 0; i < length; ++i) {
+					auto item = read_value(depth + 1);
+					if (!item)
+						return nullptr;
+					array->SetValue((int)i, item);
+				}
+				return array;
+			}
+			case CLONE_OBJECT: {
+				unsigned count = 0;
+				if (!read_u32(count) || (size_t)(_end - _data) < count)
+					return nullptr;
+				auto object = CefV8Value::CreateObject(nullptr, nullptr);
+				for (unsigned i = 0; i < count; ++i) {
+					CefString key;
+					if (!read_string(key))
+						return nullptr;
+					auto item = read_value(depth + 1);
+					if (!item)
+						return nullptr;
+					object->SetValue(key, item, V8_PROPERTY_ATTRIBUTE_NONE);
+				}
+				return object;
+			}
+			default:
+				return nullptr;
+		}
+	}
+
+private:
+
+	const char* _data;
+	const char* _end;
+};
+
+CefRefPtr<CefV8Value> create_v8_value(const char* data, size_t size)
+{
+	CloneReader reader(data, size);
+	auto value = reader.read_value(0);
+	return value && reader.done() ? value : nullptr;
+}
+
+} // end namespace
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <include/cef_v8.h>
+
+#include <vector>
+
+struct lua_State;
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Compact binary format used to send Lua values to pages without going through JavaScript source.
+ *
+ * Each value starts with a one byte `StructuredCloneTag`. Numbers are followed by a little-endian
+ * double, strings by a 32-bit byte size and their UTF-8 bytes, arrays by a 32-bit element count
+ * and their elements, objects by a 32-bit property count and their string keys and values.
+ */
+enum StructuredCloneTag
+{
+	CLONE_NULL,
+	CLONE_FALSE,
+	CLONE_TRUE,
+	CLONE_NUMBER,
+	CLONE_STRING,
+	CLONE_ARRAY,
+	CLONE_OBJECT
+};
+
+// Appends the Lua value at `index` to `buffer`. Returns false if it holds functions, userdata or is nested too deep.
+bool clone_lua_value(lua_State* L, int index, std::vector<char>& buffer);
+
+// Creates the V8 value of a cloned buffer in the entered context. Returns nullptr if the buffer is malformed.
+CefRefPtr<CefV8Value> create_v8_value(const char* data, size_t size);
+
+} // end namespace
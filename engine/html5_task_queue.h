@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+namespace PLUGIN_NAMESPACE {
+
+/**
+ * Lock-free multiple producers, single consumer queue of tasks.
+ *
+ * Any thread can push tasks, a single thread drains them in push order. Producers only exchange
+ * the queue head, so they never wait on each other or on the consumer.
+ */
+class TaskQueue
+{
+public:
+
+	typedef std::function<void()> Task;
+
+	TaskQueue() : _head(&_stub), _tail(&_stub) { _stub.next = nullptr; }
+
+	~TaskQueue()
+	{
+		while (Node* node = pop())
+			delete node;
+	}
+
+	void push(Task task)
+	{
+		Node* node = new Node();
+		node->task = std::move(task);
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	// Runs the queued tasks on the consumer thread and returns how many ran.
+	unsigned drain()
+	{
+		unsigned count = 0;
+		while (Node* node = pop()) {
+			node->task();
+			delete node;
+			++count;
+		}
+		return count;
+	}
+
+	// Runs the next queued task on the consumer thread, returns false if there was none.
+	bool run_one()
+	{
+		Node* node = pop();
+		if (node == nullptr)
+			return false;
+		node->task();
+		delete node;
+		return true;
+	}
+
+private:
+
+	struct Node
+	{
+		std::atomic<Node*> next;
+		Task task;
+	};
+
+	// Returns the next node, or nullptr if the queue is empty or a producer is mid-push.
+	Node* pop()
+	{
+		Node* tail = _tail;
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (tail == &_stub) {
+			if (next == nullptr)
+				return nullptr;
+			_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next != nullptr) {
+			_tail = next;
+			return tail;
+		}
+
+		if (tail != _head.load(std::memory_order_acquire))
+			return nullptr;
+
+		push_stub();
+		next = tail->next.load(std::memory_order_acquire);
+		if (next != nullptr) {
+			_tail = next;
+			return tail;
+		}
+		return nullptr;
+	}
+
+	void push_stub()
+	{
+		_stub.next.store(nullptr, std::memory_order_relaxed);
+		Node* previous = _head.exchange(&_stub, std::memory_order_acq_rel);
+		previous->next.store(&_stub, std::memory_order_release);
+	}
+
+	TaskQueue(const TaskQueue&) = delete;
+	TaskQueue& operator=(const TaskQueue&) = delete;
+
+	std::atomic<Node*> _head;
+	Node* _tail;
+	Node _stub;
+};
+
+} // end namespace
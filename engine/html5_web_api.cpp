@@ -1,23 +1,209 @@
+#include "html5_api.h"
+#include "html5_web_app.h"
 #include "html5_web_browser.h"
 #include "html5_web_view.h"
 #include "html5_api_bindings.h"
+#include "html5_engine_gate.h"
 
 #include <include/cef_app.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
 namespace PLUGIN_NAMESPACE {
 
-volatile int sync_point = 0;
-void set_signal() { sync_point = 1; }
-void sync_signal() { sync_point = 0; }
-void wait_for_sync() { while (sync_point == 1) CefDoMessageLoopWork(); }
+// Number of set_signal() calls not yet matched by a sync_signal() from the page. A page that missed
+// its deadline signals late, so the count keeps its signal from releasing the next frame.
+static std::atomic<int> pending_syncs(0);
+static ThreadEvent* sync_event = nullptr;
+static unsigned sync_deadline_ms = 500;
+static SyncTimeoutPolicy sync_timeout_policy = SYNC_TIMEOUT_SKIP;
+
+// Engine access of binding calls, see html5_api_bindings.h. The engine thread opens the gate while
+// blocked in wait_for_sync() and waits for the direct calls still running before it leaves.
+thread_local ApiAccess current_api_access = API_ACCESS_DIRECT;
+static thread_local unsigned direct_api_scopes = 0;
+static EngineGate engine_gate;
+
+// Writes queued by pipelined pages and the browsers of pipelined web apps, both used by the render thread.
+static ThreadCriticalSection* api_writes_cs = nullptr;
+static std::vector<std::function<void()>>* api_writes = nullptr;
+static std::vector<int>* pipelined_browsers = nullptr;
+static bool pipelined_sync_pending = false;
+
+void setup_sync()
+{
+	sync_event = stingray::api::thread->create_event(stingray::api::allocator_object, 1, 0, "HTML5 WebApp sync");
+	api_writes_cs = stingray::api::thread->create_critical_section(stingray::api::allocator_object);
+	api_writes = new std::vector<std::function<void()>>();
+	pipelined_browsers = new std::vector<int>();
+}
+
+void shutdown_sync()
+{
+	delete pipelined_browsers;
+	pipelined_browsers = nullptr;
+	delete api_writes;
+	api_writes = nullptr;
+	stingray::api::thread->destroy_critical_section(api_writes_cs, stingray::api::allocator_object);
+	api_writes_cs = nullptr;
+	stingray::api::thread->destroy_event(sync_event, stingray::api::allocator_object);
+	sync_event = nullptr;
+}
+
+void queue_api_write(std::function<void()> write)
+{
+	stingray::api::thread->enter_critical_section(api_writes_cs);
+	api_writes->push_back(std::move(write));
+	stingray::api::thread->leave_critical_section(api_writes_cs);
+}
+
+void set_web_app_pipelined(int browser_id, bool pipelined)
+{
+	stingray::api::thread->enter_critical_section(api_writes_cs);
+	auto it = std::find(pipelined_browsers->begin(), pipelined_browsers->end(), browser_id);
+	if (pipelined && it == pipelined_browsers->end())
+		pipelined_browsers->push_back(browser_id);
+	else if (!pipelined && it != pipelined_browsers->end())
+		pipelined_browsers->erase(it);
+	stingray::api::thread->leave_critical_section(api_writes_cs);
+}
+
+static bool is_current_browser_pipelined()
+{
+	CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+	CefRefPtr<CefBrowser> browser = context ? context->GetBrowser() : nullptr;
+	if (!browser)
+		return false;
+
+	stingray::api::thread->enter_critical_section(api_writes_cs);
+	const bool pipelined = std::find(pipelined_browsers->begin(), pipelined_browsers->end(), browser->GetIdentifier()) != pipelined_browsers->end();
+	stingray::api::thread->leave_critical_section(api_writes_cs);
+	return pipelined;
+}
+
+EngineApiScope::EngineApiScope() : access(API_ACCESS_DIRECT), previous_access(current_api_access), engine_waiting(true), tracked(true)
+{
+	// Calls nested in a direct scope already hold the engine in its wait.
+	if (direct_api_scopes > 0) {
+		tracked = false;
+		return;
+	}
+
+	if (!engine_gate.enter()) {
+		engine_waiting = false;
+		tracked = false;
+		// With a multi-threaded message loop pages run on CEF threads at any time, not only pipelined ones.
+		if (WebApp::multi_threaded() || is_current_browser_pipelined())
+			access = API_ACCESS_DEFERRED;
+	}
+	current_api_access = access;
+	if (tracked)
+		direct_api_scopes++;
+}
+
+EngineApiScope::~EngineApiScope()
+{
+	current_api_access = previous_access;
+	if (tracked) {
+		direct_api_scopes--;
+		engine_gate.leave();
+	}
+}
+
+void begin_pipelined_sync()
+{
+	pipelined_sync_pending = true;
+	set_signal();
+}
+
+void end_pipelined_sync()
+{
+	// Writes made by the page after a skipped sync stay queued until the next one.
+	if (pipelined_sync_pending) {
+		wait_for_sync();
+		pipelined_sync_pending = false;
+	}
+
+	std::vector<std::function<void()>> writes;
+	stingray::api::thread->enter_critical_section(api_writes_cs);
+	writes.swap(*api_writes);
+	stingray::api::thread->leave_critical_section(api_writes_cs);
+
+	for (const auto& write : writes)
+		write();
+}
+
+void set_sync_deadline(unsigned deadline_ms, SyncTimeoutPolicy policy)
+{
+	sync_deadline_ms = deadline_ms;
+	sync_timeout_policy = policy;
+}
+
+void set_signal()
+{
+	stingray::api::thread->reset_event(sync_event);
+	pending_syncs++;
+}
+
+void sync_signal()
+{
+	// Decrement without going below zero, a separate clamp could wipe out a concurrent set_signal().
+	int pending = pending_syncs.load();
+	while (pending > 0 && !pending_syncs.compare_exchange_weak(pending, pending - 1)) {}
+	if (pending <= 1)
+		stingray::api::thread->set_event(sync_event);
+}
+
+bool wait_for_sync()
+{
+	const uint64_t start_ticks = stingray::api::timer->ticks();
+	bool timed_out = false;
+	engine_gate.open();
+
+	// Keep pumping CEF while waiting, since page calls might need the browser thread. The event only
+	// wakes the loop, a late signal of a skipped frame can set it while this frame is still pending.
+	while (pending_syncs > 0) {
+		WebApp::pump();
+		if (stingray::api::thread->wait_for_event_timeout(sync_event, 1)) {
+			if (pending_syncs > 0)
+				stingray::api::thread->reset_event(sync_event);
+			continue;
+		}
+
+		const double waited_ms = stingray::api::timer->ticks_to_seconds(stingray::api::timer->ticks() - start_ticks) * 1000.0;
+		if (!timed_out && waited_ms >= sync_deadline_ms) {
+			timed_out = true;
+			record_engine_counter(ENGINE_COUNTER_SYNC_TIMEOUT, stingray::api::timer->ticks() - start_ticks);
+			if (sync_timeout_policy == SYNC_TIMEOUT_SKIP) {
+				record_engine_counter(ENGINE_COUNTER_SYNC_SKIP, 0);
+				stingray::api::log->warning("HTML5", stingray::api::error->eprintf("Web app missed its %u ms sync deadline, skipping frame", sync_deadline_ms));
+				break;
+			}
+			stingray::api::log->warning("HTML5", stingray::api::error->eprintf("Web app missed its %u ms sync deadline", sync_deadline_ms));
+		}
+	}
+
+	// Binding calls are short, let the ones that started during the wait finish before the frame goes on.
+	engine_gate.close();
+
+	record_engine_counter(ENGINE_COUNTER_SYNC_WAIT, stingray::api::timer->ticks() - start_ticks);
+	return !timed_out;
+}
 
 void bind_api_web_app(CefRefPtr<CefV8Value> stingray_ns)
 {
 	DEFINE_API("WebApp");
 
-	bind_api(ns, "sync", [](const CefV8ValueList&)
+	// The renderer signals the sync once window.update/render return, a second signal from the page could
+	// release the next frame early. Kept so pages written for explicit syncing still run.
+	bind_local_api(ns, "sync", [](const CefV8ValueList&)
 	{
-		sync_signal();
+		static std::atomic<bool> warned(false);
+		if (!warned.exchange(true))
+			stingray::api::log->warning("HTML5", "stingray.WebApp.sync() is deprecated and does nothing, web apps are synced when window.update and window.render return");
 		return CefV8Value::CreateUndefined();
 	});
 }
@@ -1,21 +1,50 @@
 #include "html5_web_app.h"
 #include "html5_web_page.h"
 #include "html5_api.h"
+#include "html5_api_profiler.h"
+#include "html5_structured_clone.h"
+#include "html5_task_queue.h"
 
 #include "stingray_api.h"
 
 #include <plugin_foundation/exception_handling.h>
+#include <plugin_foundation/id_string.h>
 
 #include <include/internal/cef_types.h>
 
 #include <tlhelp32.h>
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 
 namespace PLUGIN_NAMESPACE {
 
 volatile int _closing = 0;
 
+// Engine work posted by CEF threads when the message loop is multi-threaded, drained by pump().
+static TaskQueue* engine_tasks = nullptr;
+
+// Message pump scheduling, CEF requests work through OnScheduleMessagePumpWork from any thread.
+static const int64_t PUMP_IDLE = INT64_MAX;
+static const int64_t MAX_PUMP_DELAY_US = 1000000 / 30;
+static std::atomic<int64_t> pump_due_us(0);
+static int64_t last_pump_us = 0;
+static double pump_budget_ms = 2.0;
+static unsigned max_pump_slices = 4;
+static WebAppPumpStats pump_stats = { 0, 0.0 };
+
+static int64_t now_us()
+{
+	return (int64_t)(stingray::api::timer->ticks_to_seconds(stingray::api::timer->ticks()) * 1000000.0);
+}
+
+const char* WEB_APP_CALL_MESSAGE = "stingray.WebApp.call";
+const char* WEB_APP_EVENT_MESSAGE = "stingray.WebApp.event";
+static const char* web_app_function_names[WEB_APP_FUNCTION_COUNT] = { "update", "render", "shutdown" };
+
 std::string remove_file_name(const std::string& path)
 {
 	auto result = path.substr(0, path.find_last_of("\\/"));
@@ -41,6 +70,70 @@ private:
 	IMPLEMENT_REFCOUNTING(MessageAPIHandler);
 };
 
+// Page side of the `cefQuery` framing, see html5_web_view.h. Pages can't compute IdString64 ids.
+//   stingray.encodeQuery(name, payload) : string			Frame calling the handler `name` with a UTF-8 string payload.
+//   stingray.decodeEvents(batch) : string[]				Records of an event stream batch, one byte per character.
+class QueryFrameHandler : public CefV8Handler
+{
+public:
+	bool Execute(const CefString& name, CefRefPtr<CefV8Value>, const CefV8ValueList& arguments,
+		CefRefPtr<CefV8Value>& retval, CefString& exception) OVERRIDE
+	{
+		if (name == "encodeQuery") {
+			if (arguments.empty() || !arguments[0]->IsString()) {
+				exception = "encodeQuery expects a function name";
+				return true;
+			}
+			const std::string function_name = arguments[0]->GetStringValue().ToString();
+			const std::string payload = arguments.size() > 1 && arguments[1]->IsString() ? arguments[1]->GetStringValue().ToString() : std::string();
+
+			std::wstring frame;
+			frame.reserve(12 + payload.size());
+			const uint64_t function_id = IdString64(function_name.c_str()).id();
+			for (unsigned i = 0; i < 8; ++i)
+				frame.push_back((wchar_t)((function_id >> (i * 8)) & 0xFF));
+			for (unsigned i = 0; i < 4; ++i)
+				frame.push_back((wchar_t)((payload.size() >> (i * 8)) & 0xFF));
+			for (char c : payload)
+				frame.push_back((unsigned char)c);
+			retval = CefV8Value::CreateString(frame);
+			return true;
+		}
+
+		if (name == "decodeEvents") {
+			if (arguments.empty() || !arguments[0]->IsString()) {
+				exception = "decodeEvents expects an event batch";
+				return true;
+			}
+			const CefString batch = arguments[0]->GetStringValue();
+			const auto* data = batch.c_str();
+			const size_t size = batch.length();
+
+			std::vector<CefRefPtr<CefV8Value>> records;
+			size_t offset = 0;
+			while (offset + 4 <= size) {
+				unsigned record_size = 0;
+				for (unsigned i = 0; i < 4; ++i)
+					record_size |= (unsigned)(data[offset + i] & 0xFF) << (i * 8);
+				offset += 4;
+				if (offset + record_size > size)
+					break;
+				records.push_back(CefV8Value::CreateString(std::wstring(data + offset, data + offset + record_size)));
+				offset += record_size;
+			}
+
+			retval = CefV8Value::CreateArray((int)records.size());
+			for (size_t i = 0; i < records.size(); ++i)
+				retval->SetValue((int)i, records[i]);
+			return true;
+		}
+
+		return false;
+	}
+
+	IMPLEMENT_REFCOUNTING(QueryFrameHandler);
+};
+
 CefRefPtr<WebApp> WebApp::init()
 {
 	// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
@@ -64,7 +157,8 @@ CefRefPtr<WebApp> WebApp::init()
 	#ifdef NDEBUG
 		settings.log_severity = LOGSEVERITY_DISABLE;
 	#endif
-	settings.multi_threaded_message_loop = false;
+	settings.multi_threaded_message_loop = command_line->HasSwitch("html5-threaded-message-loop");
+	settings.external_message_pump = !settings.multi_threaded_message_loop;
 	settings.windowless_rendering_enabled = true;
 	settings.single_process = true;
 	settings.no_sandbox = true;
@@ -72,6 +166,9 @@ CefRefPtr<WebApp> WebApp::init()
 		settings.remote_debugging_port = 9089;
 	#endif
 
+	if (settings.multi_threaded_message_loop)
+		engine_tasks = new TaskQueue();
+
 	CefRefPtr<WebApp> cef_app = new WebApp();
 	CefMainArgs main_args;
 	if (!CefInitialize(main_args, settings, cef_app.get(), nullptr))
@@ -96,14 +193,73 @@ void WebApp::shutdown()
 
 	CefClearSchemeHandlerFactories();
 	CefShutdown();
+
+	unbind_api();
+
+	// Browsers are closed, drop any work they left behind.
+	delete engine_tasks;
+	engine_tasks = nullptr;
 }
 
 void WebApp::update()
 {
+	const uint64_t start_ticks = stingray::api::timer->ticks();
+	const int64_t start_us = now_us();
+
+	// Pump the work due, in slices, until the frame budget is spent.
+	pump_stats.pumps = 0;
+	while (pump_stats.pumps < max_pump_slices && pump()) {
+		pump_stats.pumps++;
+		if ((now_us() - start_us) / 1000.0 >= pump_budget_ms)
+			break;
+	}
+	pump_stats.duration_ms = (now_us() - start_us) / 1000.0;
+
+	record_engine_counter(ENGINE_COUNTER_CEF_MAIN_THREAD, stingray::api::timer->ticks() - start_ticks);
+}
+
+bool WebApp::pump()
+{
+	if (engine_tasks)
+		return engine_tasks->drain() > 0;
+
+	// Work is due when CEF asked for it, or when CEF was not pumped for a while as recommended.
+	const int64_t now = now_us();
+	if (pump_due_us > now && now - last_pump_us < MAX_PUMP_DELAY_US)
+		return false;
+
+	pump_due_us = PUMP_IDLE;
+	last_pump_us = now;
+
 	// ReSharper disable once CppLocalVariableWithNonTrivialDtorIsNeverUsed
 	FpuUnsafeScope fus;
 
 	CefDoMessageLoopWork();
+	return true;
+}
+
+void WebApp::set_pump_budget(double budget_ms, unsigned max_slices)
+{
+	pump_budget_ms = budget_ms;
+	max_pump_slices = max_slices > 0 ? max_slices : 1;
+}
+
+WebAppPumpStats WebApp::last_pump_stats()
+{
+	return pump_stats;
+}
+
+bool WebApp::multi_threaded()
+{
+	return engine_tasks != nullptr;
+}
+
+void WebApp::run_on_engine_thread(std::function<void()> task)
+{
+	if (engine_tasks)
+		engine_tasks->push(std::move(task));
+	else
+		task();
 }
 
 WebApp::WebApp(): _context_created_ref_count(0)
@@ -135,14 +291,17 @@ void WebApp::OnContextCreated(CefRefPtr< CefBrowser > browser, CefRefPtr< CefFra
 	CefRefPtr<CefV8Value> object = context->GetGlobal();
 	CefRefPtr<CefV8Handler> handler = new MessageAPIHandler(browser);
 
-	CefRefPtr<CefV8Value> stingray_ns = CefV8Value::CreateObject(nullptr, nullptr);
+	// Namespaces are materialized on first access, see bind_api().
+	CefRefPtr<CefV8Value> stingray_ns = bind_api();
 	object->SetValue("stingray", stingray_ns, V8_PROPERTY_ATTRIBUTE_NONE);
 
 	// Create global functions.
 	stingray_ns->SetValue("reload", CefV8Value::CreateFunction("reload", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
 	stingray_ns->SetValue("openDevTools", CefV8Value::CreateFunction("openDevTools", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
 
-	bind_api(stingray_ns);
+	CefRefPtr<CefV8Handler> query_handler = new QueryFrameHandler();
+	stingray_ns->SetValue("encodeQuery", CefV8Value::CreateFunction("encodeQuery", query_handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+	stingray_ns->SetValue("decodeEvents", CefV8Value::CreateFunction("decodeEvents", query_handler), V8_PROPERTY_ATTRIBUTE_READONLY);
 
 	_context_created_ref_count++;
 	if (!stingray::api::error_context->has_thread_error_context_stack()) {
@@ -156,6 +315,9 @@ void WebApp::OnContextCreated(CefRefPtr< CefBrowser > browser, CefRefPtr< CefFra
 		stingray::api::profiler->make_thread_profiler(stingray::api::allocator_object);
 	}
 
+	if (frame->IsMain())
+		_page_functions[browser->GetIdentifier()] = PageFunctions{ context };
+
 	_message_router->OnContextCreated(browser, frame, context);
 }
 
@@ -167,14 +329,114 @@ void WebApp::OnContextReleased(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame
 		stingray::api::error_context->delete_thread_error_context_stack(stingray::api::allocator_object);
 	}
 
+	auto page_functions = _page_functions.find(browser->GetIdentifier());
+	if (page_functions != _page_functions.end() && page_functions->second.context->IsSame(context))
+		_page_functions.erase(page_functions);
+
+	release_async_api_calls(context);
+
 	_message_router->OnContextReleased(browser, frame, context);
 }
 
 bool WebApp::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefProcessId source_process, CefRefPtr<CefProcessMessage> message)
 {
+	if (message->GetName() == WEB_APP_CALL_MESSAGE) {
+		auto args = message->GetArgumentList();
+		call_page_function(browser, (WebAppFunction)args->GetInt(0), args->GetDouble(1));
+		return true;
+	}
+
+	if (message->GetName() == WEB_APP_EVENT_MESSAGE) {
+		auto args = message->GetArgumentList();
+		dispatch_page_event(browser, args->GetString(0), args->GetBinary(1));
+		return true;
+	}
+
 	return _message_router->OnProcessMessageReceived(browser, source_process, message);
 }
 
+void WebApp::call_page_function(CefRefPtr<CefBrowser> browser, WebAppFunction function, double dt)
+{
+	auto page_functions = _page_functions.find(browser->GetIdentifier());
+	if (page_functions != _page_functions.end() && function < WEB_APP_FUNCTION_COUNT) {
+		CefRefPtr<CefV8Context> context = page_functions->second.context;
+		CefRefPtr<CefV8Value>& page_function = page_functions->second.functions[function];
+
+		context->Enter();
+
+		// The page might define its functions after the context creation, so resolve until found.
+		if (!page_function) {
+			CefRefPtr<CefV8Value> value = context->GetGlobal()->GetValue(web_app_function_names[function]);
+			if (value && value->IsFunction())
+				page_function = value;
+		}
+
+		if (page_function) {
+			CefV8ValueList args;
+			if (function == WEB_APP_UPDATE)
+				args.push_back(CefV8Value::CreateDouble(dt));
+			if (!page_function->ExecuteFunctionWithContext(context, nullptr, args) && page_function->HasException()) {
+				stingray::api::log->error("HTML5", stingray::api::error->eprintf("window.%s: %s",
+					web_app_function_names[function], page_function->GetException()->GetMessageA().ToString().c_str()));
+				page_function->ClearException();
+			}
+		}
+
+		context->Exit();
+	}
+
+	sync_signal();
+}
+
+void WebApp::dispatch_page_event(CefRefPtr<CefBrowser> browser, const CefString& name, CefRefPtr<CefBinaryValue> detail)
+{
+	auto page_functions = _page_functions.find(browser->GetIdentifier());
+	if (page_functions == _page_functions.end() || !detail)
+		return;
+
+	// The clone is read once from the message and decoded straight into V8 values.
+	std::vector<char> data(detail->GetSize());
+	if (!data.empty())
+		detail->GetData(&data[0], data.size(), 0);
+
+	CefRefPtr<CefV8Context> context = page_functions->second.context;
+	context->Enter();
+
+	CefRefPtr<CefV8Value> detail_value = create_v8_value(data.data(), data.size());
+	if (!detail_value) {
+		stingray::api::log->error("HTML5", stingray::api::error->eprintf("Malformed detail for event `%s`.", name.ToString().c_str()));
+		context->Exit();
+		return;
+	}
+
+	// window.dispatchEvent(new CustomEvent(name, { detail })), CEF can't call constructors directly.
+	CefRefPtr<CefV8Value> window = context->GetGlobal();
+	CefRefPtr<CefV8Value> reflect = window->GetValue("Reflect");
+	CefRefPtr<CefV8Value> event_init = CefV8Value::CreateObject(nullptr, nullptr);
+	event_init->SetValue("detail", detail_value, V8_PROPERTY_ATTRIBUTE_NONE);
+	CefRefPtr<CefV8Value> event_args = CefV8Value::CreateArray(2);
+	event_args->SetValue(0, CefV8Value::CreateString(name));
+	event_args->SetValue(1, event_init);
+
+	CefV8ValueList construct_args;
+	construct_args.push_back(window->GetValue("CustomEvent"));
+	construct_args.push_back(event_args);
+	CefRefPtr<CefV8Value> event = reflect->GetValue("construct")->ExecuteFunction(reflect, construct_args);
+
+	if (event) {
+		CefV8ValueList dispatch_args;
+		dispatch_args.push_back(event);
+		CefRefPtr<CefV8Value> dispatch = window->GetValue("dispatchEvent");
+		if (!dispatch->ExecuteFunction(window, dispatch_args) && dispatch->HasException()) {
+			stingray::api::log->error("HTML5", stingray::api::error->eprintf("%s: %s",
+				name.ToString().c_str(), dispatch->GetException()->GetMessageA().ToString().c_str()));
+			dispatch->ClearException();
+		}
+	}
+
+	context->Exit();
+}
+
 void WebApp::OnUncaughtException(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, CefRefPtr<CefV8Context>, CefRefPtr<CefV8Exception> exception, CefRefPtr<CefV8StackTrace> stack_trace)
 {
 	stingray::api::log->error("HTML5", stingray::api::error->eprintf("%s", exception->GetMessageA().ToString().c_str()));
@@ -205,7 +467,9 @@ void WebApp::OnContextInitialized()
 
 void WebApp::OnScheduleMessagePumpWork(int64 delay_ms)
 {
-	
+	const int64_t due = now_us() + (delay_ms > 0 ? delay_ms * 1000 : 0);
+	int64_t current = pump_due_us;
+	while (due < current && !pump_due_us.compare_exchange_weak(current, due)) {}
 }
 
 } // end namespace
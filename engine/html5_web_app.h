@@ -6,10 +6,39 @@
 #include <include/cef_command_line.h>
 #include <include/wrapper/cef_message_router.h>
 
+#include <functional>
+#include <unordered_map>
+
 struct ScriptApi;
 
 namespace PLUGIN_NAMESPACE {
 
+/**
+ * Page functions the engine calls every frame, i.e. `window.update(dt)`.
+ */
+enum WebAppFunction
+{
+	WEB_APP_UPDATE,
+	WEB_APP_RENDER,
+	WEB_APP_SHUTDOWN,
+	WEB_APP_FUNCTION_COUNT
+};
+
+/**
+ * Message pump slices run by the last WebApp::update().
+ */
+struct WebAppPumpStats
+{
+	unsigned pumps;
+	double duration_ms;
+};
+
+// Process message sent to the renderer to call a `WebAppFunction`, followed by the sync signal.
+extern const char* WEB_APP_CALL_MESSAGE;
+
+// Process message sent to the renderer to dispatch an event with a structured clone of a Lua value, see `html5_structured_clone.h`.
+extern const char* WEB_APP_EVENT_MESSAGE;
+
 class WebApp : public CefApp
 	, public CefRenderProcessHandler
 	, public CefBrowserProcessHandler
@@ -21,6 +50,19 @@ public:
 	static void shutdown();
 	static void update();
 
+	// Runs one slice of pending browser work on the engine thread, returns false if none was due.
+	static bool pump();
+
+	// Bounds the time and number of pump slices update() can spend per frame.
+	static void set_pump_budget(double budget_ms, unsigned max_slices);
+	static WebAppPumpStats last_pump_stats();
+
+	// True when CEF runs its message loop on its own thread, see `--html5-threaded-message-loop`.
+	static bool multi_threaded();
+
+	// Runs a task on the engine thread, immediately if CEF callbacks already run on it.
+	static void run_on_engine_thread(std::function<void()> task);
+
 	WebApp();
 	~WebApp();
 
@@ -48,6 +90,17 @@ protected: // CefRenderProcessHandler
 
 private:
 
+	void call_page_function(CefRefPtr<CefBrowser> browser, WebAppFunction function, double dt);
+	void dispatch_page_event(CefRefPtr<CefBrowser> browser, const CefString& name, CefRefPtr<CefBinaryValue> detail);
+
+	// Main frame context of a browser and its page functions, resolved on first call.
+	struct PageFunctions
+	{
+		CefRefPtr<CefV8Context> context;
+		CefRefPtr<CefV8Value> functions[WEB_APP_FUNCTION_COUNT];
+	};
+	std::unordered_map<int, PageFunctions> _page_functions;
+
 	unsigned _context_created_ref_count;
 	CefRefPtr<CefMessageRouterRendererSide> _message_router;
 
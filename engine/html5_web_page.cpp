@@ -1,5 +1,10 @@
 #include "html5_web_page.h"
 
+#include "html5_lz4.h"
+#include "html5_mime_types.h"
+#include "html5_read_mostly.h"
+#include "html5_resource_loader.h"
+
 #include "stingray_api.h"
 
 #include <plugin_foundation/id_string.h>
@@ -7,136 +12,1255 @@
 #include <plugin_foundation/vector.h>
 #include <plugin_foundation/hash_map.h>
 
-#include <include/cef_parser.h>
-#include <include/wrapper/cef_stream_resource_handler.h>
+#include <include/cef_resource_handler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ctype.h>
+#include <limits.h>
 
 namespace PLUGIN_NAMESPACE {
 
 // Data compiler resource properties
-int WEB_PAGE_RESOURCE_VERSION = 14;
+int WEB_PAGE_RESOURCE_VERSION = 20;
 const char WEB_PAGE_RESOURCE_EXTENSION[] = "html5";
 const IdString32 WEB_PAGE_RESOURCE_ID = IdString32(WEB_PAGE_RESOURCE_EXTENSION);
 
+// Project settings holding the `html5_mime_types` overrides
+const char PROJECT_SETTINGS_PATH[] = "settings.ini";
+static const unsigned MAX_MIME_TYPE_OVERRIDES = 64;
+
+// Default bytes of page data kept, see `set_web_page_memory_budget`
+static const uint64_t DEFAULT_WEB_PAGE_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+// Bytes held by all page data buffers, updated from any thread
+static std::atomic<uint64_t> decoded_bytes(0);
+
+// Marks the preloaded resources already served, see `WebPage::decoded`
+static const std::shared_ptr<const DecodedBuffer> served_resource = std::make_shared<DecodedBuffer>();
+
+DecodedBuffer::~DecodedBuffer()
+{
+	decoded_bytes -= _counted;
+}
+
+void DecodedBuffer::resize(unsigned size)
+{
+	_bytes.resize(size);
+	decoded_bytes += _bytes.capacity() - _counted;
+	_counted = _bytes.capacity();
+}
+
+typedef HashMap<IdString64, WebPagePtr, idstring_hash> WebPageMap;
+
+// Points the stylesheet links of the given page paths to their reloaded data, called with an array of paths.
+static const char SWAP_STYLESHEETS_SCRIPT[] =
+	"(function(paths) {"
+	"  var links = document.querySelectorAll('link[rel=\"stylesheet\"]');"
+	"  for (var i = 0; i < links.length; ++i) {"
+	"    var href = links[i].href.split(/[?#]/)[0];"
+	"    for (var j = 0; j < paths.length; ++j) {"
+	"      if (href.slice(-paths[j].length - 1) === '/' + paths[j])"
+	"        links[i].href = href + '?stingray-refresh=' + Date.now();"
+	"    }"
+	"  }"
+	"})";
+
+// Appends `s` as a double quoted JavaScript string literal.
+static void append_js_string(std::string& script, const char* s)
+{
+	script += '"';
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			script += '\\';
+		script += *s;
+	}
+	script += '"';
+}
+
+static unsigned align_offset(unsigned offset, unsigned alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static unsigned read_block_size(const uint8_t* p)
+{
+	unsigned size;
+	memcpy(&size, p, sizeof(size));
+	return size;
+}
+
+static void free_compile_data(AllocatorObject* compile_allocator, const DataCompileResult& result)
+{
+	if (result.data.p)
+		stingray::api::allocator_api->deallocate(compile_allocator, result.data.p);
+}
+
+// Compressors the data compiler picks from. Both write LZ4 blocks, so the choice only changes the
+// compile time and the stored size, never the decoding cost.
+enum WebPageCompressionLevel
+{
+	WEB_PAGE_COMPRESS_NONE,
+	WEB_PAGE_COMPRESS_FAST,
+	WEB_PAGE_COMPRESS_HIGH
+};
+
+// Text resources compress well and are small, so they get the best ratio. Uncompressed binary
+// formats can be large and use the fast compressor. Media formats are already compressed.
+static WebPageCompressionLevel compression_level(const char* mime_type)
+{
+	if (strncmp(mime_type, "text/", 5) == 0 || strstr(mime_type, "javascript") || strstr(mime_type, "json")
+		|| strstr(mime_type, "xml") || strstr(mime_type, "svg"))
+		return WEB_PAGE_COMPRESS_HIGH;
+	if (strstr(mime_type, "wasm") || strstr(mime_type, "octet-stream") || strstr(mime_type, "ttf") || strstr(mime_type, "otf"))
+		return WEB_PAGE_COMPRESS_FAST;
+	return WEB_PAGE_COMPRESS_NONE;
+}
+
+// Appends the file data as stored in the compiled page, compressed when it saves at least an eighth of the size.
+static void store_file_data(const char* data, unsigned size, WebPageCompressionLevel level, Vector<char>& file_data, WebPageEntry& entry)
+{
+	entry.data_offset = file_data.size();
+	entry.size = size;
+
+	if (level != WEB_PAGE_COMPRESS_NONE && size > 0) {
+		auto compress_block = level == WEB_PAGE_COMPRESS_HIGH ? lz4_compress_block_hc : lz4_compress_block;
+		for (unsigned offset = 0; offset < size; offset += WEB_PAGE_BLOCK_SIZE) {
+			const unsigned block_size = size - offset < WEB_PAGE_BLOCK_SIZE ? size - offset : WEB_PAGE_BLOCK_SIZE;
+			const unsigned header_offset = file_data.size();
+			file_data.resize(header_offset + 8 + lz4_compress_bound(block_size));
+
+			uint8_t* block = (uint8_t*)file_data.begin() + header_offset + 8;
+			unsigned stored_size = compress_block((const uint8_t*)data + offset, block_size, block, lz4_compress_bound(block_size));
+			if (stored_size == 0 || stored_size >= block_size) {
+				stored_size = block_size;
+				memcpy(block, data + offset, block_size);
+			}
+			memcpy(file_data.begin() + header_offset, &stored_size, 4);
+			memcpy(file_data.begin() + header_offset + 4, &block_size, 4);
+			file_data.resize(header_offset + 8 + stored_size);
+		}
+
+		entry.data_size = file_data.size() - entry.data_offset;
+		if (entry.data_size <= size - size / 8) {
+			entry.compression = WEB_PAGE_LZ4;
+			return;
+		}
+		file_data.resize(entry.data_offset);
+	}
+
+	file_data.insert(file_data.end(), data, data + size);
+	entry.data_size = size;
+	entry.compression = WEB_PAGE_STORED;
+}
+
+enum ByteRangeResult
+{
+	BYTE_RANGE_NONE,
+	BYTE_RANGE_SATISFIABLE,
+	BYTE_RANGE_UNSATISFIABLE
+};
+
+// Parses a single `bytes=first-last`, `bytes=first-` or `bytes=-suffix` range of a resource of `size` bytes.
+// Multiple ranges are not supported, the whole resource is served instead as HTTP allows.
+static ByteRangeResult parse_byte_range(const std::string& value, unsigned size, unsigned& first, unsigned& last)
+{
+	if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos)
+		return BYTE_RANGE_NONE;
+
+	const char* p = value.c_str() + 6;
+	const char* dash = strchr(p, '-');
+	if (!dash)
+		return BYTE_RANGE_NONE;
+
+	char* end = nullptr;
+	if (dash == p) {
+		const unsigned long long suffix = strtoull(dash + 1, &end, 10);
+		if (end == dash + 1 || *end)
+			return BYTE_RANGE_NONE;
+		if (suffix == 0 || size == 0)
+			return BYTE_RANGE_UNSATISFIABLE;
+		first = suffix >= size ? 0 : size - (unsigned)suffix;
+		last = size - 1;
+		return BYTE_RANGE_SATISFIABLE;
+	}
+
+	const unsigned long long range_first = strtoull(p, &end, 10);
+	if (end != dash)
+		return BYTE_RANGE_NONE;
+	unsigned long long range_last = size > 0 ? size - 1 : 0;
+	if (dash[1]) {
+		range_last = strtoull(dash + 1, &end, 10);
+		if (*end || range_last < range_first)
+			return BYTE_RANGE_NONE;
+	}
+	if (range_first >= size)
+		return BYTE_RANGE_UNSATISFIABLE;
+
+	first = (unsigned)range_first;
+	last = range_last >= size ? size - 1 : (unsigned)range_last;
+	return BYTE_RANGE_SATISFIABLE;
+}
+
+// Returns true if an `If-None-Match` list of entity tags holds `etag` or is `*`. `If-None-Match` uses the weak
+// comparison, so a `W/` prefix is ignored and the quoted tags must be equal.
+static bool matches_entity_tag(const std::string& value, const char* etag)
+{
+	const size_t etag_size = strlen(etag);
+	size_t i = 0;
+	while (i < value.size()) {
+		while (i < value.size() && (isspace((unsigned char)value[i]) || value[i] == ','))
+			++i;
+		if (i == value.size())
+			break;
+
+		if (value[i] == '*')
+			return true;
+		if (value.compare(i, 2, "W/") == 0)
+			i += 2;
+
+		// A quoted tag runs to its closing quote, commas can appear inside it.
+		size_t end = i;
+		if (end < value.size() && value[end] == '"') {
+			end = value.find('"', end + 1);
+			end = end == std::string::npos ? value.size() : end + 1;
+		} else {
+			while (end < value.size() && value[end] != ',' && !isspace((unsigned char)value[end]))
+				++end;
+		}
+
+		if (end - i == etag_size && value.compare(i, etag_size, etag) == 0)
+			return true;
+		i = end;
+	}
+	return false;
+}
+
+// Resolves a relative reference of an HTML file to a page path, returns false for absolute, root or fragment references.
+static bool resolve_reference(const char* base, unsigned base_size, const char* reference, unsigned reference_size, std::string& path)
+{
+	reference_size = (unsigned)(std::find_if(reference, reference + reference_size, [](char c) { return c == '?' || c == '#'; }) - reference);
+	if (reference_size == 0 || reference[0] == '/' || std::find(reference, reference + reference_size, ':') != reference + reference_size)
+		return false;
+
+	unsigned directory_size = base_size;
+	while (directory_size > 0 && base[directory_size - 1] != '/')
+		--directory_size;
+	const std::string joined = std::string(base, directory_size) + std::string(reference, reference_size);
+
+	// Remove the `.` and `..` segments.
+	path.clear();
+	size_t start = 0;
+	while (start <= joined.size()) {
+		size_t end = joined.find('/', start);
+		if (end == std::string::npos)
+			end = joined.size();
+		const std::string segment = joined.substr(start, end - start);
+		if (segment == "..") {
+			if (path.empty())
+				return false;
+			const size_t slash = path.rfind('/');
+			path.erase(slash == std::string::npos ? 0 : slash);
+		} else if (!segment.empty() && segment != ".") {
+			if (!path.empty())
+				path += '/';
+			path += segment;
+		}
+		start = end + 1;
+	}
+	return !path.empty();
+}
+
+// Appends the path ids of the files an HTML file references with `src` and `href` attributes.
+static void collect_html_references(const char* html, unsigned size, const char* path, unsigned path_size, Vector<uint64_t>& path_ids)
+{
+	std::string reference_path;
+	for (unsigned i = 1; i < size; ++i) {
+		unsigned name_size = 0;
+		if (i + 3 <= size && _strnicmp(html + i, "src", 3) == 0)
+			name_size = 3;
+		else if (i + 4 <= size && _strnicmp(html + i, "href", 4) == 0)
+			name_size = 4;
+		if (name_size == 0 || !isspace((unsigned char)html[i - 1]))
+			continue;
+
+		unsigned p = i + name_size;
+		while (p < size && isspace((unsigned char)html[p]))
+			++p;
+		if (p == size || html[p] != '=')
+			continue;
+		++p;
+		while (p < size && isspace((unsigned char)html[p]))
+			++p;
+		if (p == size || (html[p] != '"' && html[p] != '\''))
+			continue;
+
+		const char quote = html[p++];
+		const char* value = html + p;
+		while (p < size && html[p] != quote)
+			++p;
+		if (p < size && resolve_reference(path, path_size, value, (unsigned)(html + p - value), reference_path))
+			path_ids.push_back(IdString64((unsigned)reference_path.size(), reference_path.c_str()).id());
+		i = p;
+	}
+}
+
+// Decodes a whole compressed resource, returns false if a block is malformed.
+static bool decode_resource(const uint8_t* buffer, unsigned stored_size, uint8_t* dest, unsigned size)
+{
+	unsigned stored_offset = 0, offset = 0;
+	while (stored_offset + 8 <= stored_size) {
+		const unsigned block_stored_size = read_block_size(buffer + stored_offset);
+		const unsigned block_size = read_block_size(buffer + stored_offset + 4);
+		const uint8_t* block = buffer + stored_offset + 8;
+		if (block_size > size - offset || block_stored_size > stored_size - stored_offset - 8)
+			return false;
+		if (block_stored_size == block_size)
+			memcpy(dest + offset, block, block_size);
+		else if (!lz4_decompress_block(block, block_stored_size, dest + offset, block_size))
+			return false;
+		stored_offset += 8 + block_stored_size;
+		offset += block_size;
+	}
+	return offset == size;
+}
+
+// Serves a page resource from the page data or its preloaded decoded data. The lookup and the decoding of compressed blocks run on the
+// resource loader thread, CEF is signaled through its callbacks once the response or the next block is ready.
+// Single byte ranges are answered with partial responses so media can seek without reloading.
+// Responses carry a strong ETag of the resource content, so CEF revalidates its cached copies with `If-None-Match`
+// and unchanged resources are answered with 304 and no body.
+class WebResourceHandler : public CefResourceHandler
+{
+public:
+
+	WebResourceHandler(const CefString& url, CefRefPtr<CefBrowser> browser)
+		: _url(url.ToString()), _browser(browser), _status(404), _first(0), _remaining(0)
+		, _stored_offset(0), _block(nullptr), _block_size(0), _block_offset(0), _failed(false), _cancelled(false)
+	{
+		_etag[0] = '\0';
+	}
+
+	bool ProcessRequest(CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback) OVERRIDE
+	{
+		std::string range, if_none_match;
+		CefRequest::HeaderMap headers;
+		request->GetHeaderMap(headers);
+		for (const auto& header : headers) {
+			if (_stricmp(header.first.ToString().c_str(), "Range") == 0)
+				range = header.second.ToString();
+			else if (_stricmp(header.first.ToString().c_str(), "If-None-Match") == 0)
+				if_none_match = header.second.ToString();
+		}
+
+		_range = range;
+		_if_none_match = if_none_match;
+		CefRefPtr<WebResourceHandler> handler = this;
+		queue_resource_task([handler, callback]() { handler->process(callback, true); });
+		return true;
+	}
+
+	void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length, CefString&) OVERRIDE
+	{
+		response->SetStatus(_status);
+		response_length = _remaining;
+		if (_status == 404) {
+			response->SetStatusText("Not Found");
+			return;
+		}
+
+		CefResponse::HeaderMap headers;
+		headers.insert(std::make_pair("Accept-Ranges", "bytes"));
+		headers.insert(std::make_pair("Cache-Control", "no-cache"));
+		headers.insert(std::make_pair("ETag", _etag));
+
+		char content_range[64];
+		if (_status == 206) {
+			sprintf(content_range, "bytes %u-%u/%u", _first, _first + _remaining - 1, _resource.size);
+			headers.insert(std::make_pair("Content-Range", content_range));
+			response->SetStatusText("Partial Content");
+		} else if (_status == 416) {
+			sprintf(content_range, "bytes */%u", _resource.size);
+			headers.insert(std::make_pair("Content-Range", content_range));
+			response->SetStatusText("Range Not Satisfiable");
+		} else if (_status == 304) {
+			response->SetStatusText("Not Modified");
+		} else {
+			response->SetStatusText("OK");
+		}
+
+		response->SetMimeType(_resource.mime_type.c_str());
+		response->SetHeaderMap(headers);
+	}
+
+	bool ReadResponse(void* data_out, int bytes_to_read, int& bytes_read, CefRefPtr<CefCallback> callback) OVERRIDE
+	{
+		bytes_read = 0;
+		if (_remaining == 0 || _failed)
+			return false;
+
+		// Compressed blocks are decoded on the loader thread, CEF reads again once the callback continues.
+		if (_block_offset == _block_size) {
+			if (_resource.compression == WEB_PAGE_STORED) {
+				if (!next_block())
+					return false;
+				return ReadResponse(data_out, bytes_to_read, bytes_read, callback);
+			}
+			CefRefPtr<WebResourceHandler> handler = this;
+			queue_resource_task([handler, callback]() {
+				if (handler->_cancelled)
+					return;
+				if (!handler->next_block())
+					handler->_failed = true;
+				callback->Continue();
+			});
+			return true;
+		}
+
+		unsigned size = _block_size - _block_offset;
+		if (size > (unsigned)bytes_to_read)
+			size = bytes_to_read;
+		if (size > _remaining)
+			size = _remaining;
+		memcpy(data_out, _block + _block_offset, size);
+		_block_offset += size;
+		_remaining -= size;
+		bytes_read = size;
+		return true;
+	}
+
+	void Cancel() OVERRIDE
+	{
+		_cancelled = true;
+	}
+
+private:
+
+	// Looks the resource up and answers CEF, called on the resource loader thread. A request for a page that is not
+	// loaded yet waits for the main thread to load it, then is processed again without waiting.
+	void process(CefRefPtr<CefCallback> callback, bool can_wait)
+	{
+		if (_cancelled)
+			return;
+
+		std::function<void()> retry;
+		if (can_wait) {
+			CefRefPtr<WebResourceHandler> handler = this;
+			retry = [handler, callback]() { handler->process(callback, false); };
+		}
+		const WebResourceLookup lookup = find_web_resource(_url.c_str(), _browser, _resource, retry);
+		if (lookup == WEB_RESOURCE_LOADING)
+			return;
+		if (lookup == WEB_RESOURCE_NOT_FOUND || open())
+			callback->Continue();
+		else
+			callback->Cancel();
+	}
+
+	// Prepares the response of the found resource, returns false if a range cannot be decoded.
+	bool open()
+	{
+		sprintf(_etag, "\"%016llx\"", (unsigned long long)_resource.content_hash);
+		if (!_if_none_match.empty() && matches_entity_tag(_if_none_match, _etag)) {
+			_status = 304;
+			return true;
+		}
+
+		_status = 200;
+		_remaining = _resource.size;
+		if (_range.empty())
+			return true;
+
+		unsigned last = 0;
+		switch (parse_byte_range(_range, _resource.size, _first, last)) {
+			case BYTE_RANGE_SATISFIABLE:
+				_status = 206;
+				_remaining = last - _first + 1;
+				return seek(_first);
+			case BYTE_RANGE_UNSATISFIABLE:
+				_status = 416;
+				_remaining = 0;
+				return true;
+			default:
+				return true;
+		}
+	}
+
+	// Moves to a decoded offset, only the block holding it is decoded.
+	bool seek(unsigned offset)
+	{
+		if (_resource.compression == WEB_PAGE_STORED) {
+			if (!next_block())
+				return false;
+			_block_offset = offset;
+			return true;
+		}
+
+		while (_stored_offset < _resource.stored_size) {
+			const unsigned size = read_block_size(_resource.buffer + _stored_offset + 4);
+			if (offset < size) {
+				if (!next_block())
+					return false;
+				_block_offset = offset;
+				return true;
+			}
+			offset -= size;
+			_stored_offset += 8 + read_block_size(_resource.buffer + _stored_offset);
+		}
+		return false;
+	}
+
+	bool next_block()
+	{
+		if (_stored_offset >= _resource.stored_size)
+			return false;
+
+		if (_resource.compression == WEB_PAGE_STORED) {
+			_block = _resource.buffer;
+			_block_size = _resource.stored_size;
+			_stored_offset = _resource.stored_size;
+		} else {
+			const uint8_t* header = _resource.buffer + _stored_offset;
+			const unsigned stored_size = read_block_size(header);
+			const unsigned size = read_block_size(header + 4);
+			_stored_offset += 8 + stored_size;
+
+			if (stored_size == size) {
+				_block = header + 8;
+			} else {
+				_decoded.resize(size);
+				if (!lz4_decompress_block(header + 8, stored_size, _decoded.data(), size)) {
+					stingray::api::log->error("HTML5", stingray::api::error->eprintf("Corrupted web page resource `%s`.", _resource.path.c_str()));
+					return false;
+				}
+				_block = _decoded.data();
+			}
+			_block_size = size;
+		}
+
+		_block_offset = 0;
+		return true;
+	}
+
+	std::string _url;
+	CefRefPtr<CefBrowser> _browser;
+	std::string _range;
+	std::string _if_none_match;
+	WebResource _resource;
+	char _etag[24];
+
+	// Response status, first byte and number of bytes left to serve
+	int _status;
+	unsigned _first;
+	unsigned _remaining;
+
+	unsigned _stored_offset;
+	DecodedBuffer _decoded;
+	const uint8_t* _block;
+	unsigned _block_size;
+	unsigned _block_offset;
+
+	// Set by the loader thread when a block is corrupted and by CEF when the request is canceled
+	std::atomic<bool> _failed;
+	std::atomic<bool> _cancelled;
+
+	IMPLEMENT_REFCOUNTING(WebResourceHandler);
+};
+
+const WebPageEntry* WebPage::find_entry(IdString64 path_id) const
+{
+	const WebPageEntry* first = entries;
+	const WebPageEntry* last = entries + header->entry_count;
+	const WebPageEntry* entry = std::lower_bound(first, last, path_id.id(),
+		[](const WebPageEntry& e, uint64_t id) { return e.path_id < id; });
+	return entry != last && entry->path_id == path_id.id() ? entry : nullptr;
+}
+
+const char* WebPage::mime_type(const WebPageEntry& entry) const
+{
+	const unsigned* offsets = reinterpret_cast<const unsigned*>(data + header->mime_type_offsets);
+	return (const char*)data + offsets[entry.mime_type];
+}
+
+const unsigned* WebPage::preloads(const WebPageEntry& entry) const
+{
+	static const unsigned no_preloads = 0;
+	if (entry.preload_offset == 0)
+		return &no_preloads;
+	return reinterpret_cast<const unsigned*>(data + entry.preload_offset);
+}
+
+// Calls `visit(page_id, page_name, page_name_size, path, path_size)` for the pages a stingray://<page name>/<resource path>
+// url could name, shortest page name first, until it returns true. The page name is the host followed by a number of
+// path components, query and fragment do not select a different resource.
+template <class Visit>
+static void visit_url_pages(const char* url, Visit visit)
+{
+	const char* url_end = url + strcspn(url, "?#");
+	const char* page_name = strstr(url, "://");
+	if (page_name == nullptr || page_name >= url_end)
+		return;
+	page_name += 3;
+
+	for (const char* page_name_end = page_name; page_name_end <= url_end; ++page_name_end) {
+		if (page_name_end != url_end && *page_name_end != '/')
+			continue;
+
+		const unsigned page_name_size = (unsigned)(page_name_end - page_name);
+		const char* path = page_name_end == url_end ? url_end : page_name_end + 1;
+		if (visit(IdString64(page_name_size, page_name), page_name, page_name_size, path, (unsigned)(url_end - path)))
+			return;
+	}
+}
+
+// Loaded pages by name. Published indexes are never modified, writers publish a modified copy instead.
+struct WebPageIndex
+{
+	ALLOCATOR_AWARE;
+
+	explicit WebPageIndex(Allocator& a) : pages(a) {}
+
+	WebPageMap pages;
+};
+
+/**
+ * Read-mostly database of the loaded pages.
+ *
+ * Lookups read the published index without locking. Loading and refreshing pages take the database lock, publish
+ * a new index and retire the previous one. Retired indexes are freed once the lookups that could read them are
+ * done (see `ReadMostly`), lookups keep the pages they found through their own references.
+ *
+ * The resource manager is only used on the main thread: pages are loaded, swapped and removed there, lookups of
+ * pages that are not loaded wait for the next update.
+ */
 struct WebPageDatabase
 {
 	ALLOCATOR_AWARE;
 
 	WebPageDatabase(Allocator& a)
 		: allocator(a)
-		, pages(a)
+		, cs(stingray::api::thread->create_critical_section(stingray::api::allocator_object))
+		, index(MAKE_NEW(a, WebPageIndex, a), [this](WebPageIndex* pages) { MAKE_DELETE(allocator, pages); })
+		, refreshing(a)
+		, page_type_id(IdString64(WEB_PAGE_RESOURCE_EXTENSION).id())
+		, budget(DEFAULT_WEB_PAGE_MEMORY_BUDGET)
+		, use_count(0)
+		, resource_version(stingray::api::resource_manager->version())
 	{}
 
-	WebPagePtr find_page(const char* page_name)
+	~WebPageDatabase()
 	{
-		for (unsigned i = 0; i < pages.size(); ++i) {
-			if (pages[i]->name == page_name) {
-				return pages[i];
-			}
+		stingray::api::thread->destroy_critical_section(cs, stingray::api::allocator_object);
+	}
+
+	struct Lock
+	{
+		explicit Lock(WebPageDatabase& db) : cs(db.cs) { stingray::api::thread->enter_critical_section(cs); }
+		~Lock() { stingray::api::thread->leave_critical_section(cs); }
+		ThreadCriticalSection* cs;
+	};
+
+	WebPagePtr find_page(IdString64 page_id)
+	{
+		ReadMostly<WebPageIndex>::ReadSection pages(index);
+		auto it = pages->pages.find(page_id);
+		if (it == pages->pages.end())
+			return nullptr;
+		return it->second;
+	}
+
+	// Writer side, called with the lock held. The ones using the resource manager run on the main thread.
+
+	WebPageIndex* copy_index() const
+	{
+		const WebPageIndex* current = index.get();
+		WebPageIndex* copy = MAKE_NEW(allocator, WebPageIndex, allocator);
+		for (auto it = current->pages.begin(); it != current->pages.end(); ++it)
+			copy->pages.insert(it->first, it->second);
+		return copy;
+	}
+
+	void publish(WebPageIndex* pages)
+	{
+		index.publish(pages);
+	}
+
+	// Forgets pages whose resource was unloaded along with its package and swaps reloaded pages to their new
+	// data. Resources being served keep the previous version of their page.
+	void remove_unloaded_pages()
+	{
+		const unsigned version = stingray::api::resource_manager->version();
+		if (version == resource_version)
+			return;
+
+		const WebPageIndex* current = index.get();
+		WebPageIndex* pages = copy_index();
+		for (auto it = current->pages.begin(); it != current->pages.end(); ++it) {
+			if (!stingray::api::resource_manager->can_get_by_id(page_type_id, it->first.id())
+				|| stingray::api::resource_manager->get_by_id(page_type_id, it->first.id()) != it->second->source)
+				swap_page(*pages, it->first, it->second);
 		}
-		return nullptr;
+		publish(pages);
+		resource_version = version;
 	}
 
-	WebPagePtr load_page(const char* page_name)
+	// Binds a page to its current data in an index being modified, or removes it if its resource was unloaded.
+	// The version its views show is kept until refresh_page compares it with the reloaded one.
+	void swap_page(WebPageIndex& pages, IdString64 page_id, const WebPagePtr& old_page)
 	{
-		WebPagePtr page = MAKE_NEW(allocator, WebPage, allocator);
+		WebPagePtr page;
+		if (stingray::api::resource_manager->can_get_by_id(page_type_id, page_id.id())) {
+			const uint8_t* data = (const uint8_t*)stingray::api::resource_manager->get_by_id(page_type_id, page_id.id());
+			page = bind_page(data, old_page->name.c_str(), old_page->name.size());
+		}
+		if (!page) {
+			pages.pages.erase(page_id);
+			refreshing.erase(page_id);
+			return;
+		}
 
-		page->name = page_name;
-		page->data = (uint8_t*)stingray::api::resource_manager->get(WEB_PAGE_RESOURCE_EXTENSION, page_name);
-		const unsigned int* index = reinterpret_cast<const unsigned int*>(page->data);
-		unsigned index_size = index[0];
-		for (size_t i = 1; i < index_size; i += 4) {
-			unsigned path_offset = index[i];
-			unsigned path_size = index[i + 1];
-			unsigned file_offset = index[i + 2];
-			unsigned file_size = index[i + 3];
+		page->last_used = old_page->last_used.load();
+		page->browsers = old_page->browsers;
+		pages.pages[page_id] = page;
+		if (refreshing.find(page_id) == refreshing.end())
+			refreshing[page_id] = old_page;
+	}
+
+	// Drops page data until it fits the budget with `reserve` more bytes, least recently used pages first. Pages
+	// drop their preloaded resources, decoded block by block again when requested, and pages no view uses are
+	// removed from the index, loaded again on the main thread when requested. Their data is freed once the
+	// resources being served are done. `keep` is never removed.
+	void evict_pages(uint64_t reserve = 0, const WebPage* keep = nullptr)
+	{
+		uint64_t used = decoded_bytes.load() + reserve;
+		if (used <= budget)
+			return;
 
-			WebResourcePtr res(MAKE_NEW(allocator, WebResource, allocator));
-			res->path = DynamicString(allocator, (const char*)page->data + path_offset, path_size);
+		std::vector<std::pair<IdString64, WebPagePtr>> pages;
+		const WebPageIndex* current = index.get();
+		for (auto it = current->pages.begin(); it != current->pages.end(); ++it)
+			pages.push_back(std::make_pair(it->first, it->second));
+		std::sort(pages.begin(), pages.end(), [](const std::pair<IdString64, WebPagePtr>& a, const std::pair<IdString64, WebPagePtr>& b) {
+			return a.second->last_used.load() < b.second->last_used.load();
+		});
 
-			DynamicString extension = path::get_extension(res->path.c_str(), allocator);
-			res->mime_type = get_mime_type(extension.c_str());
-			res->size = file_size;
-			res->buffer = page->data + file_offset;
+		WebPageIndex* kept = nullptr;
+		for (const auto& it : pages) {
+			WebPage& page = *it.second;
+			for (auto& decoded : page.decoded) {
+				if (used <= budget)
+					break;
+				std::shared_ptr<const DecodedBuffer> buffer = std::atomic_load(&decoded);
+				if (buffer && buffer != served_resource && std::atomic_compare_exchange_strong(&decoded, &buffer, std::shared_ptr<const DecodedBuffer>()))
+					used -= std::min<uint64_t>(used, buffer->bytes());
+			}
+			if (used <= budget)
+				break;
+			if (&page == keep || !page.browsers.empty())
+				continue;
+
+			if (kept == nullptr)
+				kept = copy_index();
+			kept->pages.erase(it.first);
+			refreshing.erase(it.first);
+			used -= std::min<uint64_t>(used, page.storage.bytes());
+		}
+		if (kept)
+			publish(kept);
+	}
 
-			page->resources.push_back(res);
+	void release_pages(int browser_id)
+	{
+		const WebPageIndex* pages = index.get();
+		for (auto it = pages->pages.begin(); it != pages->pages.end(); ++it) {
+			WebPage& page = *it->second;
+			for (unsigned i = 0; i < page.browsers.size(); ++i) {
+				if (page.browsers[i]->GetIdentifier() == browser_id) {
+					page.browsers[i] = page.browsers.back();
+					page.browsers.pop_back();
+					break;
+				}
+			}
+			if (page.last_browser_id.load() == browser_id)
+				page.last_browser_id = -1;
 		}
+	}
 
-		pages.push_back(page);
+	static void use_page(WebPage& page, CefRefPtr<CefBrowser> browser)
+	{
+		bool found = false;
+		for (unsigned i = 0; i < page.browsers.size() && !found; ++i)
+			found = page.browsers[i]->IsSame(browser);
+		if (!found)
+			page.browsers.push_back(browser);
+		page.last_browser_id = browser->GetIdentifier();
+	}
 
+	WebPagePtr load_page(IdString64 page_id, const char* page_name, unsigned page_name_size)
+	{
+		const uint8_t* data = (const uint8_t*)stingray::api::resource_manager->get_by_id(page_type_id, page_id.id());
+		WebPagePtr page = bind_page(data, page_name, page_name_size);
+		if (!page)
+			return nullptr;
+
+		page->last_used = ++use_count;
+		WebPageIndex* pages = copy_index();
+		pages->pages[page_id] = page;
+		publish(pages);
+		evict_pages(0, page.get());
 		return page;
 	}
 
-	WebResourcePtr load_resource(const char* url)
+	// Views to update once the database lock is released, CEF is not called while holding it.
+	struct PageRefresh
 	{
-		CefURLParts url_parts;
-		CefParseURL(url, url_parts);
+		PageRefresh() : reload(false) {}
 
-		DynamicString page_name(allocator, CefString(&url_parts.host).ToString().c_str());
+		std::vector<CefRefPtr<CefBrowser>> browsers;
+		bool reload;
+		std::string swap_stylesheets;
+	};
 
-		unsigned current_path_index = 0;
-		Vector<DynamicString> paths(allocator);
-		string::split(CefString(&url_parts.path).ToString().c_str(), "/", paths);
+	// Swaps a loaded page to its reloaded data, unless a lookup already did, and collects the views using
+	// changed files. Returns false if no view needs to be refreshed.
+	bool refresh_page(IdString64 page_id, PageRefresh& refresh)
+	{
+		WebPagePtr page = find_page(page_id);
+		if (!page)
+			return false;
 
-		while (true) {
-			if (stingray::api::resource_manager->can_get(WEB_PAGE_RESOURCE_EXTENSION, page_name.c_str())) {
-				WebPagePtr page = find_page(page_name.c_str());
-				if (!page) {
-					page = load_page(page_name.c_str());
-				}
+		if (!stingray::api::resource_manager->can_get_by_id(page_type_id, page_id.id())
+			|| stingray::api::resource_manager->get_by_id(page_type_id, page_id.id()) != page->source) {
+			WebPageIndex* pages = copy_index();
+			swap_page(*pages, page_id, page);
+			publish(pages);
+			page = find_page(page_id);
+		}
 
-				if (!page)
-					return nullptr;
+		auto it = refreshing.find(page_id);
+		if (!page || it == refreshing.end())
+			return false;
+		const WebPagePtr old_page = it->second;
+		refreshing.erase(page_id);
 
-				unsigned url_hash = hash32(url);
-				for (unsigned i = 0; i < page->resources.size(); ++i) {
-					if (page->resources[i]->hash == url_hash) {
-						return page->resources[i];
+		// Both versions are sorted by path id, so changed files are found in a single pass.
+		std::string stylesheets;
+		const unsigned old_count = old_page->header->entry_count;
+		unsigned i = 0, j = 0;
+		while (i < old_count || j < page->header->entry_count) {
+			if (j == page->header->entry_count
+				|| (i < old_count && old_page->entries[i].path_id < page->entries[j].path_id)) {
+				// Removed files are only noticed by a full reload.
+				refresh.reload = true;
+				++i;
+			} else if (i == old_count || page->entries[j].path_id < old_page->entries[i].path_id) {
+				// Added files are not referenced by unchanged ones.
+				++j;
+			} else {
+				const WebPageEntry& entry = page->entries[j];
+				if (entry.content_hash != old_page->entries[i].content_hash) {
+					if (strcmp(page->mime_type(entry), "text/css") == 0) {
+						stylesheets += stylesheets.empty() ? "" : ",";
+						append_js_string(stylesheets, (const char*)page->data + entry.path_offset);
+					} else {
+						refresh.reload = true;
 					}
 				}
+				++i;
+				++j;
+			}
+		}
 
-				DynamicString resource_path(allocator);
-				string::join(&paths[current_path_index], paths.size() - current_path_index, "/", resource_path);
+		if (!refresh.reload && stylesheets.empty())
+			return false;
 
-				for (unsigned i = 0; i < page->resources.size(); ++i) {
-					if (page->resources[i]->path == resource_path) {
-						page->resources[i]->hash = hash32(url);
-						page->resources[i]->url = url;
-						return page->resources[i];
-					}
-				}
+		refresh.browsers = page->browsers;
+		refresh.swap_stylesheets = std::string(SWAP_STYLESHEETS_SCRIPT) + "([" + stylesheets + "]);";
+		return true;
+	}
+
+	// Binds the page to a copy of its compiled data, made in a single allocation. The resource manager may free
+	// its data while the page is still being served.
+	WebPagePtr bind_page(const uint8_t* data, const char* page_name, unsigned page_name_size)
+	{
+		const WebPageHeader* header = reinterpret_cast<const WebPageHeader*>(data);
+		if (header->version != (unsigned)WEB_PAGE_RESOURCE_VERSION) {
+			DynamicString name(allocator, page_name, page_name_size);
+			stingray::api::log->error("HTML5", stingray::api::error->eprintf("Web page `%s` was compiled with version %u, expected %d.",
+				name.c_str(), header->version, WEB_PAGE_RESOURCE_VERSION));
+			return nullptr;
+		}
 
-				return nullptr;
+		Allocator* a = &allocator;
+		WebPagePtr page(MAKE_NEW(allocator, WebPage, allocator), [a](WebPage* p) { MAKE_DELETE_TYPE(*a, WebPage, p); });
+		page->name = DynamicString(allocator, page_name, page_name_size);
+		page->source = data;
+		page->storage.resize(header->data_size);
+		memcpy(page->storage.data(), data, header->data_size);
+		page->data = page->storage.data();
+		page->header = reinterpret_cast<const WebPageHeader*>(page->data);
+		page->entries = reinterpret_cast<const WebPageEntry*>(page->data + sizeof(WebPageHeader));
+		page->decoded.resize(header->entry_count);
+		return page;
+	}
+
+	// Main thread side.
+
+	void update()
+	{
+		if (stingray::api::resource_manager->version() != resource_version) {
+			Lock lock(*this);
+			remove_unloaded_pages();
+		}
+		page_loads.drain();
+	}
+
+	// Loads the page a url names unless it is loaded.
+	void load_url_page(const char* url)
+	{
+		visit_url_pages(url, [this](IdString64 page_id, const char* page_name, unsigned page_name_size, const char*, unsigned) {
+			if (find_page(page_id))
+				return true;
+			if (!stingray::api::resource_manager->can_get_by_id(page_type_id, page_id.id()))
+				return false;
+			Lock lock(*this);
+			load_page(page_id, page_name, page_name_size);
+			return true;
+		});
+	}
+
+	// Reader side, safe to call from any thread.
+
+	// Finds the page and the entry of a url in the loaded pages, the page is registered as used by the browser.
+	// Returns WEB_RESOURCE_LOADING if none of the pages the url could name is loaded.
+	WebResourceLookup find_resource(const char* url, CefRefPtr<CefBrowser> browser, WebPagePtr& found_page, const WebPageEntry*& found_entry)
+	{
+		WebResourceLookup lookup = WEB_RESOURCE_LOADING;
+		visit_url_pages(url, [&](IdString64 page_id, const char*, unsigned, const char* path, unsigned path_size) {
+			WebPagePtr page = find_page(page_id);
+			if (!page)
+				return false;
+
+			lookup = WEB_RESOURCE_NOT_FOUND;
+			const WebPageEntry* entry = page->find_entry(IdString64(path_size, path));
+			if (entry == nullptr)
+				return true;
+
+			page->last_used = ++use_count;
+			if (browser && page->last_browser_id.load() != browser->GetIdentifier()) {
+				Lock lock(*this);
+				use_page(*page, browser);
 			}
 
-			if (current_path_index >= paths.size())
-				break;
+			found_page = page;
+			found_entry = entry;
+			lookup = WEB_RESOURCE_FOUND;
+			return true;
+		});
+		return lookup;
+	}
 
-			append(page_name, "/");
-			append(page_name, paths[current_path_index++].c_str());
+	WebResourceLookup load_resource(const char* url, CefRefPtr<CefBrowser> browser, WebResource& resource, std::function<void()> retry)
+	{
+		WebPagePtr page;
+		const WebPageEntry* entry = nullptr;
+		const WebResourceLookup lookup = find_resource(url, browser, page, entry);
+		if (lookup == WEB_RESOURCE_LOADING) {
+			if (!retry)
+				return WEB_RESOURCE_NOT_FOUND;
+			// The main thread loads the page at its next update, then the lookup runs again.
+			const std::string page_url(url);
+			page_loads.push([this, page_url, retry]() {
+				load_url_page(page_url.c_str());
+				queue_resource_task(retry);
+			});
+			return WEB_RESOURCE_LOADING;
 		}
+		if (lookup == WEB_RESOURCE_NOT_FOUND)
+			return lookup;
+
+		resource.page = page;
+		resource.path.assign((const char*)page->data + entry->path_offset, entry->path_size);
+		resource.mime_type = page->mime_type(*entry);
+		resource.stored_size = entry->data_size;
+		resource.size = entry->size;
+		resource.compression = (WebPageCompression)entry->compression;
+		resource.content_hash = entry->content_hash;
 
-		return nullptr;
+		// Preloaded resources are served from their decoded data, others from the page data the resource
+		// references. Decoded data is only served once, CEF revalidates its cached copy afterwards and gets no
+		// body back.
+		resource.data = std::atomic_exchange(&page->decoded[entry - page->entries], served_resource);
+		if (resource.data && resource.data != served_resource) {
+			resource.stored_size = resource.size;
+			resource.compression = WEB_PAGE_STORED;
+			resource.buffer = resource.data->data();
+		} else {
+			resource.data = nullptr;
+			resource.buffer = page->data + entry->data_offset;
+		}
+		return WEB_RESOURCE_FOUND;
+	}
+
+	// Queues the decoding of the compressed resources the HTML file of the url references, called on the resource
+	// loader thread once the main thread loaded the page. Each resource is a background task, so requests are
+	// served in between.
+	void preload(const char* url)
+	{
+		WebPagePtr page;
+		const WebPageEntry* entry = nullptr;
+		if (find_resource(url, nullptr, page, entry) != WEB_RESOURCE_FOUND)
+			return;
+		const unsigned* preloads = page->preloads(*entry);
+
+		// Make room by dropping what less recently used pages preloaded, this page was just looked up.
+		uint64_t preload_size = 0;
+		for (unsigned i = 0; i < preloads[0]; ++i)
+			preload_size += page->entries[preloads[1 + i]].size;
+		{
+			Lock lock(*this);
+			evict_pages(preload_size, page.get());
+		}
+
+		for (unsigned i = 0; i < preloads[0]; ++i) {
+			const unsigned index = preloads[1 + i];
+			if (page->entries[index].compression != WEB_PAGE_LZ4)
+				continue;
+
+			// The new document requests the resources the previous one was served again.
+			std::shared_ptr<const DecodedBuffer> served = served_resource;
+			std::atomic_compare_exchange_strong(&page->decoded[index], &served, std::shared_ptr<const DecodedBuffer>());
+
+			queue_background_resource_task([page, index]() {
+				WebPageDatabase::Access access;
+				if (access.db)
+					access.db->decode_preload(*page, index);
+			});
+		}
 	}
 
-	WebResourcePtr get(const char* url)
+	// Decodes a preloaded resource unless it was requested meanwhile, called on the resource loader thread.
+	void decode_preload(WebPage& page, unsigned index)
 	{
-		return load_resource(url);
+		if (std::atomic_load(&page.decoded[index]))
+			return;
+
+		// Preloading is an optimization, it never goes over budget.
+		const WebPageEntry& preload = page.entries[index];
+		if (decoded_bytes.load() + preload.size > budget)
+			return;
+
+		auto decoded = std::make_shared<DecodedBuffer>(preload.size);
+		if (!decode_resource(page.data + preload.data_offset, preload.data_size, decoded->data(), preload.size)) {
+			stingray::api::log->error("HTML5", stingray::api::error->eprintf("Corrupted web page resource `%s`.", (const char*)page.data + preload.path_offset));
+			return;
+		}
+
+		std::shared_ptr<const DecodedBuffer> expected;
+		std::atomic_compare_exchange_strong(&page.decoded[index], &expected, std::shared_ptr<const DecodedBuffer>(decoded));
 	}
 
 	Allocator& allocator;
-	Vector<WebPagePtr> pages;
 
-	static WebPageDatabase* instance;
+	// Serializes the writers, lookups only take it to load a page or register a view
+	ThreadCriticalSection* cs;
+
+	// Published index, replaced by the writers
+	ReadMostly<WebPageIndex> index;
+
+	// Previous versions of reloaded pages, until refresh_page updates their views
+	WebPageMap refreshing;
+
+	uint64_t page_type_id;
+
+	// Bytes of page data kept, see evict_pages()
+	std::atomic<uint64_t> budget;
+
+	// Number of resource lookups, orders the pages by last use
+	std::atomic<uint64_t> use_count;
+
+	// Resource manager version the loaded pages were last checked against, main thread only
+	unsigned resource_version;
+
+	// Loads of the pages lookups wait for, run by the main thread at its next update
+	TaskQueue page_loads;
+
+	// Database of the running plugin. CEF threads read it through an Access, shutdown waits for them to leave.
+	static std::atomic<WebPageDatabase*> instance;
+	static std::atomic<int> users;
+
+	struct Access
+	{
+		// Count the user before loading the instance, so shutdown can't delete it in between.
+		Access() { ++users; db = instance.load(); }
+		~Access() { --users; }
+		WebPageDatabase* db;
+	};
 };
 
-WebPageDatabase* WebPageDatabase::instance = nullptr;
+std::atomic<WebPageDatabase*> WebPageDatabase::instance(nullptr);
+std::atomic<int> WebPageDatabase::users(0);
 
 /**
  * Define plugin resource compiler.
+ *
+ * Converts the file folder read by the data compiler to the compiled web page layout (see `WebPageHeader`),
+ * so the runtime can serve resources straight from the loaded data.
  */
 DataCompileResult web_page_compiler(DataCompileParameters *input)
 {
-	return stingray::api::data_compile_params->read_file_folder(input);
+	DataCompileResult folder = stingray::api::data_compile_params->read_file_folder(input);
+	if (folder.error)
+		return folder;
+
+	AllocatorObject* compile_allocator = stingray::api::data_compile_params->allocator(input);
+	const unsigned* index = reinterpret_cast<const unsigned*>(folder.data.p);
+	const unsigned entry_count = index[0];
+
+	// Project settings can add or replace mime types, they stay valid until the settings buffer is freed.
+	MimeTypeEntry overrides[MAX_MIME_TYPE_OVERRIDES];
+	unsigned override_count = 0;
+	DataCompileResult settings = { { nullptr, 0 }, { nullptr, 0 }, nullptr };
+	if (stingray::api::data_compile_params->exists(input, PROJECT_SETTINGS_PATH)) {
+		settings = stingray::api::data_compile_params->read_file(input, PROJECT_SETTINGS_PATH);
+		if (!settings.error && settings.data.p)
+			override_count = parse_mime_type_overrides(settings.data.p, settings.data.len, overrides, MAX_MIME_TYPE_OVERRIDES);
+	}
+
+	Vector<WebPageEntry> entries(allocator);
+	Vector<const char*> mime_types(allocator);
+	Vector<char> paths(allocator);
+	Vector<char> file_data(allocator);
+	entries.resize(entry_count);
+
+	// Files HTML files reference, as [html path id, count, path id 1 ... path id n] runs
+	Vector<uint64_t> references(allocator);
+
+	// Paths follow the mime types, their offsets are patched once the mime types are known.
+	for (unsigned i = 0; i < entry_count; ++i) {
+		const unsigned* file = index + 1 + i * 4;
+		const char* path = folder.data.p + file[0];
+		WebPageEntry& entry = entries[i];
+		entry.path_id = IdString64(file[1], path).id();
+		entry.path_offset = paths.size();
+		entry.path_size = file[1];
+		entry.content_hash = IdString64(file[3], folder.data.p + file[2]).id();
+		entry.preload_offset = 0;
+		paths.insert(paths.end(), path, path + file[1]);
+		paths.push_back('\0');
+
+		const char* mime_type = resolve_mime_type(path, file[1], overrides, override_count);
+		entry.mime_type = mime_types.size();
+		for (unsigned m = 0; m < mime_types.size(); ++m) {
+			if (strcmp(mime_types[m], mime_type) == 0) {
+				entry.mime_type = m;
+				break;
+			}
+		}
+		if (entry.mime_type == mime_types.size())
+			mime_types.push_back(mime_type);
+
+		if (strcmp(mime_type, "text/html") == 0) {
+			const unsigned run = references.size();
+			references.push_back(entry.path_id);
+			references.push_back(0);
+			collect_html_references(folder.data.p + file[2], file[3], path, file[1], references);
+			references[run + 1] = references.size() - run - 2;
+		}
+
+		store_file_data(folder.data.p + file[2], file[3], compression_level(mime_type), file_data, entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const WebPageEntry& a, const WebPageEntry& b) { return a.path_id < b.path_id; });
+	for (unsigned i = 1; i < entry_count; ++i) {
+		if (entries[i].path_id == entries[i - 1].path_id) {
+			stingray::api::allocator_api->deallocate(compile_allocator, folder.data.p);
+			free_compile_data(compile_allocator, settings);
+			DataCompileResult result = { { nullptr, 0 }, { nullptr, 0 }, "Web page resource paths have colliding hashes." };
+			return result;
+		}
+	}
+
+	const unsigned entries_offset = sizeof(WebPageHeader);
+	const unsigned mime_type_offsets = entries_offset + entry_count * sizeof(WebPageEntry);
+	const unsigned preloads_offset = mime_type_offsets + mime_types.size() * sizeof(unsigned);
+
+	// Preload lists hold the indexes of the referenced files in the sorted entries, the page itself and
+	// files the folder does not have are left out.
+	auto find_entry_index = [&entries, entry_count](uint64_t path_id) {
+		const WebPageEntry* entry = std::lower_bound(entries.begin(), entries.begin() + entry_count, path_id,
+			[](const WebPageEntry& e, uint64_t id) { return e.path_id < id; });
+		return entry != entries.begin() + entry_count && entry->path_id == path_id ? (unsigned)(entry - entries.begin()) : UINT_MAX;
+	};
+	Vector<unsigned> preloads(allocator);
+	for (unsigned run = 0; run < references.size(); run += 2 + (unsigned)references[run + 1]) {
+		const unsigned html_index = find_entry_index(references[run]);
+		const unsigned list = preloads.size();
+		preloads.push_back(0);
+		for (unsigned r = 0; r < references[run + 1]; ++r) {
+			const unsigned index = find_entry_index(references[run + 2 + r]);
+			if (index == UINT_MAX || index == html_index || std::find(preloads.begin() + list + 1, preloads.end(), index) != preloads.end())
+				continue;
+			preloads.push_back(index);
+		}
+		preloads[list] = preloads.size() - list - 1;
+		if (preloads[list] == 0)
+			preloads.resize(list);
+		else
+			entries[html_index].preload_offset = preloads_offset + list * sizeof(unsigned);
+	}
+
+	const unsigned strings_offset = preloads_offset + preloads.size() * sizeof(unsigned);
+	unsigned mime_types_size = 0;
+	for (unsigned m = 0; m < mime_types.size(); ++m)
+		mime_types_size += strlen(mime_types[m]) + 1;
+	const unsigned paths_offset = strings_offset + mime_types_size;
+
+	unsigned data_size = align_offset(paths_offset + paths.size(), WEB_PAGE_DATA_ALIGNMENT);
+	for (unsigned i = 0; i < entry_count; ++i)
+		data_size = align_offset(data_size + entries[i].data_size, WEB_PAGE_DATA_ALIGNMENT);
+
+	char* data = (char*)stingray::api::allocator_api->allocate(compile_allocator, data_size, WEB_PAGE_DATA_ALIGNMENT);
+	memset(data, 0, data_size);
+
+	WebPageHeader* header = reinterpret_cast<WebPageHeader*>(data);
+	header->version = WEB_PAGE_RESOURCE_VERSION;
+	header->data_size = data_size;
+	header->entry_count = entry_count;
+	header->mime_type_count = mime_types.size();
+	header->mime_type_offsets = mime_type_offsets;
+
+	unsigned* offsets = reinterpret_cast<unsigned*>(data + mime_type_offsets);
+	unsigned string_offset = strings_offset;
+	for (unsigned m = 0; m < mime_types.size(); ++m) {
+		offsets[m] = string_offset;
+		const unsigned mime_type_size = strlen(mime_types[m]);
+		memcpy(data + string_offset, mime_types[m], mime_type_size);
+		string_offset += mime_type_size + 1;
+	}
+
+	memcpy(data + preloads_offset, preloads.begin(), preloads.size() * sizeof(unsigned));
+	memcpy(data + paths_offset, paths.begin(), paths.size());
+
+	unsigned file_offset = align_offset(paths_offset + paths.size(), WEB_PAGE_DATA_ALIGNMENT);
+	for (unsigned i = 0; i < entry_count; ++i) {
+		WebPageEntry& entry = entries[i];
+		memcpy(data + file_offset, file_data.begin() + entry.data_offset, entry.data_size);
+		entry.path_offset += paths_offset;
+		entry.data_offset = file_offset;
+		file_offset = align_offset(file_offset + entry.data_size, WEB_PAGE_DATA_ALIGNMENT);
+	}
+	memcpy(data + entries_offset, entries.begin(), entry_count * sizeof(WebPageEntry));
+
+	stingray::api::allocator_api->deallocate(compile_allocator, folder.data.p);
+	free_compile_data(compile_allocator, settings);
+
+	DataCompileResult result = { { data, data_size }, { nullptr, 0 }, nullptr };
+	return result;
 }
 
 void setup_web_page_database()
@@ -146,7 +1270,11 @@ void setup_web_page_database()
 
 void shutdown_web_page_database()
 {
-	MAKE_DELETE_TYPE(WebPageDatabase::instance->allocator, WebPageDatabase, WebPageDatabase::instance);
+	// Lookups are short, let the ones CEF threads started finish before the pages go away.
+	WebPageDatabase* db = WebPageDatabase::instance.exchange(nullptr);
+	while (WebPageDatabase::users > 0)
+		std::this_thread::yield();
+	MAKE_DELETE_TYPE(db->allocator, WebPageDatabase, db);
 }
 
 /**
@@ -165,40 +1293,89 @@ void setup_web_page_compiler(GetApiFunction get_engine_api)
 	stingray::api::data_compiler->add_compiler(WEB_PAGE_RESOURCE_EXTENSION, WEB_PAGE_RESOURCE_VERSION, web_page_compiler);
 }
 
-DynamicString get_mime_type(const char* extension)
+WebResourceLookup find_web_resource(const char* url, CefRefPtr<CefBrowser> browser, WebResource& resource, std::function<void()> retry)
+{
+	WebPageDatabase::Access access;
+	if (access.db == nullptr)
+		return WEB_RESOURCE_NOT_FOUND;
+	return access.db->load_resource(url, browser, resource, retry);
+}
+
+void release_web_pages(int browser_id)
 {
-	HKEY key = nullptr;
-	DynamicString mime_type(allocator, "application/unknown");
+	// Views still closing after shutdown have nothing left to release.
+	WebPageDatabase::Access access;
+	if (access.db == nullptr)
+		return;
+	WebPageDatabase::Lock lock(*access.db);
+	access.db->release_pages(browser_id);
+	access.db->evict_pages();
+}
 
-	if (RegOpenKeyEx(HKEY_CLASSES_ROOT, extension, 0, KEY_READ, &key) == ERROR_SUCCESS) {
-		char content_type_buffer[256] = { 0 };
-		DWORD buf_size = sizeof content_type_buffer;
+// The functions below are called by the engine on the main thread, like the database setup and shutdown.
 
-		// Get content type
-		if (RegQueryValueEx(key, "Content Type", nullptr, nullptr, (LPBYTE)content_type_buffer, &buf_size) == ERROR_SUCCESS)
-			mime_type = content_type_buffer;
+void update_web_pages()
+{
+	WebPageDatabase::instance.load()->update();
+}
 
-		RegCloseKey(key);
-	}
+void set_web_page_memory_budget(uint64_t bytes)
+{
+	WebPageDatabase* db = WebPageDatabase::instance.load();
+	WebPageDatabase::Lock lock(*db);
+	db->budget = bytes;
+	db->evict_pages();
+}
 
-	return mime_type;
+uint64_t web_page_memory_usage()
+{
+	return decoded_bytes.load();
 }
 
-WebResourcePtr find_web_resource(const char* url)
+void preload_web_page(const char* url)
 {
-	return WebPageDatabase::instance->get(url);
+	WebPageDatabase::instance.load()->load_url_page(url);
+
+	const std::string page_url(url);
+	queue_background_resource_task([page_url]() {
+		WebPageDatabase::Access access;
+		if (access.db)
+			access.db->preload(page_url.c_str());
+	});
+}
+
+bool can_refresh_web_pages(uint64_t type)
+{
+	const WebPageDatabase* db = WebPageDatabase::instance.load();
+	return db != nullptr && type == db->page_type_id;
+}
+
+void refresh_web_page(uint64_t name)
+{
+	WebPageDatabase* db = WebPageDatabase::instance.load();
+	WebPageDatabase::PageRefresh refresh;
+	{
+		WebPageDatabase::Lock lock(*db);
+		if (!db->refresh_page(IdString64(name), refresh))
+			return;
+	}
+
+	for (auto& browser : refresh.browsers) {
+		if (refresh.reload)
+			browser->ReloadIgnoreCache();
+		else
+			browser->GetMainFrame()->ExecuteJavaScript(refresh.swap_stylesheets, browser->GetMainFrame()->GetURL(), 0);
+	}
 }
 
 CefRefPtr<CefResourceHandler> WebPageSchemeHandlerFactory::Create(
-	CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, const CefString&, CefRefPtr<CefRequest> request)
+	CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, const CefString&, CefRefPtr<CefRequest> request)
 {
-	auto resource = find_web_resource(request->GetURL().ToString().c_str());
-	if (!resource)
-		return nullptr;
+	// A view navigating away no longer uses the pages of its previous document.
+	if (browser && frame && frame->IsMain() && request->GetResourceType() == RT_MAIN_FRAME)
+		release_web_pages(browser->GetIdentifier());
 
-	// Create a stream reader for the web page resource.
-	CefRefPtr<CefStreamReader> stream = CefStreamReader::CreateForData(resource->buffer, resource->size);
-	return new CefStreamResourceHandler(resource->mime_type.c_str(), stream);
+	return new WebResourceHandler(request->GetURL(), browser);
 }
 
 } // end namespace
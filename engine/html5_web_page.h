@@ -1,83 +1,163 @@
 #pragma once
 
-#include "shared_ptr.h"
-
 #include <engine_plugin_api/plugin_api.h>
 
 #include <plugin_foundation/allocator.h>
+#include <plugin_foundation/hash_map.h>
+#include <plugin_foundation/id_string.h>
 #include <plugin_foundation/string.h>
 #include <plugin_foundation/vector.h>
 
+#include <include/cef_browser.h>
 #include <include/cef_request.h>
 #include <include/cef_scheme.h>
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace PLUGIN_NAMESPACE {
 
 	using namespace stingray_plugin_foundation;
 
-	struct WebResource
+	// Compiled web page data layout, all offsets are relative to the start of the data:
+	//
+	// [WebPageHeader]
+	// [WebPageEntry 1] ... [WebPageEntry n], sorted by path id
+	// [offset_to_mime_type_1] ... [offset_to_mime_type_m]
+	// [preload lists, each a count followed by entry indexes]
+	// [mime types and paths, null terminated]
+	// [file data, each aligned to WEB_PAGE_DATA_ALIGNMENT]
+	//
+	// Compressed file data is a sequence of [stored_size][size][block] blocks of at most
+	// WEB_PAGE_BLOCK_SIZE bytes once decoded, blocks with stored_size == size are not compressed.
+	static const unsigned WEB_PAGE_DATA_ALIGNMENT = 16;
+	static const unsigned WEB_PAGE_BLOCK_SIZE = 64 * 1024;
+
+	enum WebPageCompression
 	{
-		ALLOCATOR_AWARE;
-
-		explicit WebResource(Allocator& a)
-			: allocator(a), hash(0), url(a), path(a), mime_type(a), buffer(nullptr), size(0)
-		{
-		}
-
-		WebResource(const WebResource& wpf)
-			: allocator(wpf.allocator), hash(wpf.hash), url(wpf.url), path(wpf.path), mime_type(wpf.mime_type), buffer(wpf.buffer), size(wpf.size)
-		{
-		}
+		WEB_PAGE_STORED,
+		WEB_PAGE_LZ4
+	};
 
-		WebResource& operator=(const WebResource& wpf)
-		{
-			if (this != &wpf) {
-				this->~WebResource();
-				new (this) WebResource(wpf);
-			}
-			return *this;
-		}
+	struct WebPageHeader
+	{
+		unsigned version;
+		// Size of the whole compiled page data
+		unsigned data_size;
+		unsigned entry_count;
+		unsigned mime_type_count;
+		unsigned mime_type_offsets;
+	};
 
-		Allocator& allocator;
-		unsigned hash;
-		DynamicString url;
-		DynamicString path;
-		DynamicString mime_type;
-		uint8_t* buffer;
-		uint32_t size;
+	struct WebPageEntry
+	{
+		uint64_t path_id;
+		// Hash of the decoded file data, served as the resource ETag
+		uint64_t content_hash;
+		unsigned path_offset;
+		unsigned path_size;
+		unsigned data_offset;
+		unsigned data_size;
+		unsigned size;
+		unsigned compression;
+		unsigned mime_type;
+		// Offset of the list of entries an HTML file references, or 0 if it has none
+		unsigned preload_offset;
 	};
 
-	typedef shared_ptr<WebResource> WebResourcePtr;
+	// Page data owned by the plugin, a copy of the compiled page or a decoded resource. Its bytes are counted
+	// against the page memory budget while it lives.
+	class DecodedBuffer
+	{
+	public:
+		DecodedBuffer() : _counted(0) {}
+		explicit DecodedBuffer(unsigned size) : _counted(0) { resize(size); }
+		~DecodedBuffer();
+
+		void resize(unsigned size);
+		uint8_t* data() { return _bytes.data(); }
+		// Bytes counted against the budget
+		size_t bytes() const { return _counted; }
+		const uint8_t* data() const { return _bytes.data(); }
+
+	private:
+		DecodedBuffer(const DecodedBuffer&) = delete;
+		DecodedBuffer& operator=(const DecodedBuffer&) = delete;
+
+		std::vector<uint8_t> _bytes;
+		size_t _counted;
+	};
 
 	struct WebPage
 	{
 		ALLOCATOR_AWARE;
 
 		explicit WebPage(Allocator& a)
-			: allocator(a), name(a), resources(a), data(nullptr)
+			: allocator(a), name(a), source(nullptr), data(nullptr), header(nullptr), entries(nullptr), last_used(0), last_browser_id(-1)
 		{
 		}
 
+		// Returns the entry of a resource path, or nullptr if the page does not have it.
+		const WebPageEntry* find_entry(IdString64 path_id) const;
+
+		const char* mime_type(const WebPageEntry& entry) const;
+
+		// Returns the entry indexes an HTML file references, the first value is their count.
+		const unsigned* preloads(const WebPageEntry& entry) const;
+
 		Allocator& allocator;
 
 		// Page resource name
 		DynamicString name;
 
-		// All files in package
-		Vector<WebResourcePtr> resources;
-
-		// The entire content of the web page folder will be returned in a buffer with the following layout :
-		// 
-		// [number_of_files]
-		// [offset_to_path_1] [size_of_path_1] [offset_to_file_data_1] [size_of_file_data_1]
-		// [offset_to_path_2] [size_of_path_2] [offset_to_file_data_2] [size_of_file_data_2]
-		// ...
-		// [offset_to_path_n][size_of_path_n][offset_to_file_data_n][size_of_file_data_n]
-		// [buffer_data]
-		uint8_t* data;
+		// Compiled page data of the resource manager the page was copied from, only compared to find reloaded pages.
+		// The resource manager frees it when its package unloads or reloads.
+		const void* source;
+
+		// Copy of the compiled page data, valid as long as the page is referenced
+		DecodedBuffer storage;
+		const uint8_t* data;
+		const WebPageHeader* header;
+		const WebPageEntry* entries;
+
+		// Database lookup count at the last request, least recently used pages are evicted first
+		std::atomic<uint64_t> last_used;
+
+		// Browsers of the views that loaded resources of the page, refreshed when the page is reloaded. Pages without
+		// browsers can be evicted. Guarded by the database lock, lookups only take it when the browser is not the
+		// last one registered.
+		std::vector<CefRefPtr<CefBrowser>> browsers;
+		std::atomic<int> last_browser_id;
+
+		// Compressed resources decoded ahead of their first request by entry index, accessed with the `std::atomic_*`
+		// shared pointer functions. Served resources are dropped and marked, so they are not decoded again.
+		std::vector<std::shared_ptr<const DecodedBuffer>> decoded;
 	};
 
-	typedef shared_ptr<WebPage> WebPagePtr;
+	// Pages are referenced from the published indexes and the resources being served, on any thread.
+	typedef std::shared_ptr<WebPage> WebPagePtr;
+
+	// Resource of a loaded page. The resource references its page, so it is served from the page data even
+	// after the page was reloaded or unloaded.
+	struct WebResource
+	{
+		WebResource() : buffer(nullptr), stored_size(0), size(0), compression(WEB_PAGE_STORED), content_hash(0) {}
+
+		WebPagePtr page;
+		std::string path;
+		std::string mime_type;
+		const uint8_t* buffer;
+		uint32_t stored_size;
+		uint32_t size;
+		WebPageCompression compression;
+		uint64_t content_hash;
+
+		// Preloaded decoded data `buffer` points into, or null when it points into the page data
+		std::shared_ptr<const DecodedBuffer> data;
+	};
 
 	void setup_web_page_database();
 
@@ -87,9 +167,39 @@ namespace PLUGIN_NAMESPACE {
 
 	void setup_web_page_compiler(GetApiFunction get_engine_api);
 
-	DynamicString get_mime_type(const char* extension);
+	enum WebResourceLookup
+	{
+		WEB_RESOURCE_FOUND,
+		WEB_RESOURCE_NOT_FOUND,
+		// The page is loaded on the main thread, `retry` is queued on the resource loader thread once it is.
+		WEB_RESOURCE_LOADING
+	};
+
+	// Finds the resource of a stingray:// url, the page is kept loaded for the browser until it is released. Only the
+	// main thread loads pages, a lookup of a page that is not loaded yet waits for it when given a `retry` task.
+	WebResourceLookup find_web_resource(const char* url, CefRefPtr<CefBrowser> browser, WebResource& resource, std::function<void()> retry);
+
+	// Releases the pages a browser loaded, so they can be evicted once over budget.
+	void release_web_pages(int browser_id);
+
+	// Bytes of page data kept before least recently used pages drop their preloaded resources and the ones no view
+	// uses are evicted.
+	void set_web_page_memory_budget(uint64_t bytes);
+
+	// Bytes of page data currently held, loaded pages, preloaded resources and blocks being served.
+	uint64_t web_page_memory_usage();
+
+	// Loads the page of a stingray:// url and decodes the resources its HTML references on the resource loader thread,
+	// behind the requests of the views. Called on the main thread or by a binding call while the engine waits.
+	void preload_web_page(const char* url);
+
+	// Swaps reloaded pages, forgets unloaded ones and loads the pages lookups wait for, called every frame.
+	void update_web_pages();
+
+	bool can_refresh_web_pages(uint64_t type);
 
-	WebResourcePtr find_web_resource(const char* url);
+	// Binds a loaded page to its reloaded data, then reloads the views using changed files or swaps their changed stylesheets.
+	void refresh_web_page(uint64_t name);
 
 	class WebPageSchemeHandlerFactory : public CefSchemeHandlerFactory {
 	public:
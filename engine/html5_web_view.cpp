@@ -1,6 +1,8 @@
 #include "html5_web_view.h"
 #include "html5_web_app.h"
 #include "html5_api.h"
+#include "html5_event_stream.h"
+#include "html5_web_page.h"
 
 #include "stingray_api.h"
 
@@ -28,8 +30,11 @@ WebView::WebView(WindowPtr window, MaterialPtr material)
 	, _texture_buffer_handle(UINT_MAX)
 	, _texture_buffer_size(0)
 	, _current_url()
-	, _function_handlers()
+	, _function_handlers(allocator)
+	, _query_payload(allocator)
 	, _modifiers(EVENTFLAG_NONE)
+	, _staging_cs(stingray::api::thread->create_critical_section(stingray::api::allocator_object))
+	, _staging_pending(false)
 {
 	CefMessageRouterConfig config;
 	config.js_query_function = "cefQuery";
@@ -37,6 +42,8 @@ WebView::WebView(WindowPtr window, MaterialPtr material)
 
 	_resolution[0] = 0;
 	_resolution[1] = 0;
+	_window_size[0] = _window_size[1] = 0;
+	_staging_size[0] = _staging_size[1] = 0;
 
 	_message_router = CefMessageRouterBrowserSide::Create(config);
 
@@ -45,11 +52,25 @@ WebView::WebView(WindowPtr window, MaterialPtr material)
 		_modifiers |= EVENTFLAG_CAPS_LOCK_ON;
 	else
 		_modifiers &= ~EVENTFLAG_CAPS_LOCK_ON;
+
+	// stingray.resolution -> little-endian 32-bit width and height of the view.
+	add_execute_handler("stingray.resolution", [this](const char*, unsigned, FunctionCallback callback)
+	{
+		CefRect rect;
+		GetViewRect(_browser, rect);
+		char data[8];
+		for (unsigned i = 0; i < 4; ++i) {
+			data[i] = (char)((rect.width >> (i * 8)) & 0xFF);
+			data[4 + i] = (char)((rect.height >> (i * 8)) & 0xFF);
+		}
+		send_query_response(callback, data, sizeof(data));
+	});
 }
 
 WebView::~WebView()
 {
 	close_browser();
+	stingray::api::thread->destroy_critical_section(_staging_cs, stingray::api::allocator_object);
 }
 
 WindowPtr WebView::get_window_or_default() const
@@ -63,6 +84,9 @@ void WebView::create_browser(const CefString& url)
 
 	auto window_owner = get_window_or_default();
 	HWND hwnd = (HWND)stingray::api::script->Window->id(window_owner);
+	auto window_rect = stingray::api::script->Window->rect(window_owner);
+	_window_size[0] = window_rect.pos[2];
+	_window_size[1] = window_rect.pos[3];
 	info.SetAsWindowless(hwnd, true);
 
 	CefBrowserSettings brsettings;
@@ -136,6 +160,11 @@ void WebView::open_dev_tools(const CefPoint& pt) const
 void WebView::load_page(const char* new_url)
 {
 	_current_url = new_url;
+
+	// Decode the page scripts and stylesheets while the browser starts up.
+	if (strncmp(new_url, "stingray://", 11) == 0)
+		preload_web_page(new_url);
+
 	if (!_browser) {
 		create_browser(new_url);
 	} else {
@@ -166,7 +195,15 @@ void WebView::focus() const
 
 void WebView::add_execute_handler(const char* name, FunctionHandler handler)
 {
-	_function_handlers[name] = handler;
+	_function_handlers[IdString64(name).id()] = handler;
+}
+
+void WebView::send_query_response(FunctionCallback callback, const char* data, unsigned size)
+{
+	std::wstring response(size, L'\0');
+	for (unsigned i = 0; i < size; ++i)
+		response[i] = (unsigned char)data[i];
+	callback->Success(response);
 }
 
 void WebView::set_resolution(int cx, int cy)
@@ -346,6 +383,7 @@ void WebView::on_resize(void* obj, WindowPtr window, int x, int y, int width, in
 
 void WebView::OnRenderViewReady(CefRefPtr<CefBrowser>)
 {
+	_message_router->AddHandler(event_stream_handler(), true);
 	_message_router->AddHandler(this, false);
 }
 
@@ -356,6 +394,7 @@ void WebView::OnBeforeClose(CefRefPtr<CefBrowser> browser)
 		_message_router->RemoveHandler(this);
 	}
 	_message_router->OnBeforeClose(browser);
+	release_web_pages(browser->GetIdentifier());
 }
 
 void WebView::OnRenderProcessTerminated(CefRefPtr<CefBrowser> browser, TerminationStatus)
@@ -377,26 +416,47 @@ bool WebView::OnConsoleMessage(CefRefPtr<CefBrowser>, const CefString& message,
 
 bool WebView::OnQuery(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, int64, const CefString& request, bool, FunctionCallback callback)
 {
-#if 0
-	Buffer request_buffer(request.ToString().c_str(), static_cast<unsigned>(request.size()));
-	DynamicConfigValue data(_allocator);
-	sjson::parse(request_buffer, data);
+	static const unsigned QUERY_HEADER_SIZE = 12;
 
-	bool err = false;
-	auto function_name = data["type"].to_string(err);
-	auto func = _function_handlers.find(IdString64(function_name));
-	if (func != _function_handlers.end()) {
-		func->second(data, callback);
+	const auto* frame = request.c_str();
+	const size_t frame_size = request.length();
+	if (frame == nullptr || frame_size < QUERY_HEADER_SIZE)
+		return false;
+
+	uint64_t function_id = 0;
+	for (unsigned i = 0; i < 8; ++i)
+		function_id |= (uint64_t)(frame[i] & 0xFF) << (i * 8);
+
+	auto func = _function_handlers.find(function_id);
+	if (func == _function_handlers.end()) {
+		// Function does not exist.
+		return false;
+	}
+
+	unsigned payload_size = 0;
+	for (unsigned i = 0; i < 4; ++i)
+		payload_size |= (unsigned)(frame[8 + i] & 0xFF) << (i * 8);
+	if (QUERY_HEADER_SIZE + (size_t)payload_size > frame_size) {
+		callback->Failure(-1, "Truncated query payload");
 		return true;
 	}
-#endif
-	// Function does not exist.
-	return false;
+
+	_query_payload.resize(payload_size);
+	for (unsigned i = 0; i < payload_size; ++i)
+		_query_payload[i] = (char)frame[QUERY_HEADER_SIZE + i];
+
+	func->second(_query_payload.begin(), payload_size, callback);
+	return true;
 }
 
 bool WebView::GetViewRect(CefRefPtr<CefBrowser>, CefRect& out_rect)
 {
 	if (_resolution[0] == 0 || _resolution[1] == 0) {
+		// Engine APIs can't be used from the CEF thread, use the window size known at creation.
+		if (WebApp::multi_threaded()) {
+			out_rect.Set(0, 0, _window_size[0], _window_size[1]);
+			return out_rect.width != 0 && out_rect.height != 0;
+		}
 		auto window = get_window_or_default();
 		if (window == nullptr)
 			return false;
@@ -415,6 +475,37 @@ void WebView::OnPaint(CefRefPtr<CefBrowser>, PaintElementType, const RectList&,
 	if (_browser == nullptr || WebApp::closing())
 		return;
 
+	if (WebApp::multi_threaded()) {
+		// Stage the frame for the engine thread. Frames painted before the engine uploads replace the staged one.
+		stingray::api::thread->enter_critical_section(_staging_cs);
+		_staging_buffer.assign((const char*)buffer, (const char*)buffer + width * height * 4);
+		_staging_size[0] = width;
+		_staging_size[1] = height;
+		const bool upload_pending = _staging_pending;
+		_staging_pending = true;
+		stingray::api::thread->leave_critical_section(_staging_cs);
+
+		if (!upload_pending) {
+			CefRefPtr<WebView> web_view = this;
+			WebApp::run_on_engine_thread([web_view]() { web_view->upload_staging_buffer(); });
+		}
+		return;
+	}
+
+	upload_texture_buffer(buffer, width, height);
+}
+
+void WebView::upload_staging_buffer()
+{
+	stingray::api::thread->enter_critical_section(_staging_cs);
+	if (_browser != nullptr && !WebApp::closing())
+		upload_texture_buffer(_staging_buffer.data(), _staging_size[0], _staging_size[1]);
+	_staging_pending = false;
+	stingray::api::thread->leave_critical_section(_staging_cs);
+}
+
+void WebView::upload_texture_buffer(const void* buffer, int width, int height)
+{
 	// Allocate texture buffer if it does not exist or if the requested size has changed.
 	auto texture_buffer_size = width * height * 4;
 	if (_texture_buffer_handle == UINT_MAX || _texture_buffer_size != texture_buffer_size) {
@@ -454,9 +545,13 @@ bool WebView::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefProcess
 
 void WebView::OnAfterCreated(CefRefPtr<CefBrowser> browser)
 {
-	if (!_browser)
-		_browser = browser;
-	invalidate();
+	CefRefPtr<WebView> web_view = this;
+	WebApp::run_on_engine_thread([web_view, browser]()
+	{
+		if (!web_view->_browser)
+			web_view->_browser = browser;
+		web_view->invalidate();
+	});
 }
 
 void WebView::OnLoadStart(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, TransitionType transition_type)
@@ -3,6 +3,8 @@
 #include <engine_plugin_api/plugin_api.h>
 #include <plugin_foundation/vector2.h>
 #include <plugin_foundation/vector3.h>
+#include <plugin_foundation/hash_map.h>
+#include <plugin_foundation/vector.h>
 
 #include <include/cef_browser.h>
 #include <include/cef_client.h>
@@ -10,12 +12,20 @@
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
 namespace PLUGIN_NAMESPACE {
 
+/**
+ * `cefQuery` requests are binary frames carried one byte per string character:
+ * a little-endian 64-bit function id (`IdString64` of the handler name), a little-endian
+ * 32-bit payload size and the payload bytes. Responses use the same one byte per character encoding.
+ * Pages build frames with `stingray.encodeQuery(name, payload)`, i.e.
+ * `cefQuery({ request: stingray.encodeQuery("stingray.resolution"), onSuccess: ... })`.
+ */
 typedef CefRefPtr<CefMessageRouterBrowserSide::Callback> FunctionCallback;
-typedef std::function<void(void*, FunctionCallback)> FunctionHandler;
-typedef std::unordered_map<std::string, FunctionHandler> FunctionHandlerMap;
+typedef std::function<void(const char* payload, unsigned size, FunctionCallback callback)> FunctionHandler;
+typedef stingray_plugin_foundation::HashMap<uint64_t, FunctionHandler> FunctionHandlerMap;
 
 class WebView : public CefClient,
 	public CefLifeSpanHandler,
@@ -40,6 +50,7 @@ public:
 	void reload() const;
 	void close_browser();
 	void add_execute_handler(const char* name, FunctionHandler handler);
+	static void send_query_response(FunctionCallback callback, const char* data, unsigned size);
 	CefRefPtr<CefBrowser> browser() const { return _browser; }
 	stingray_plugin_foundation::Vector2 resolution() const { return stingray_plugin_foundation::vector2(_resolution[0], _resolution[1]); };
 	void set_resolution(int cx, int cy);
@@ -114,6 +125,8 @@ private:
 
 	void create_browser(CefString const& url);
 	void clean_texture_buffer();
+	void upload_texture_buffer(const void* buffer, int width, int height);
+	void upload_staging_buffer();
 	WindowPtr get_window_or_default() const;
 
 	static void send_mouse_event(void* obj, int button, bool up);
@@ -125,10 +138,19 @@ private:
 	std::string _current_url;
 	CefRefPtr<CefBrowser> _browser;
 	FunctionHandlerMap _function_handlers;
+	stingray_plugin_foundation::Vector<char> _query_payload;
 	CefRefPtr<CefMessageRouterBrowserSide> _message_router;
 	uint32 _modifiers;
 	int _cursor_pos[2];
 	int _resolution[2];
+	int _window_size[2];
+
+	// Last painted frame waiting for the engine thread, when the CEF message loop is multi-threaded.
+	ThreadCriticalSection* _staging_cs;
+	std::vector<char> _staging_buffer;
+	int _staging_size[2];
+	bool _staging_pending;
+
 	IMPLEMENT_REFCOUNTING(WebView)
 };
 
@@ -94,6 +94,7 @@ PLUGIN_NAMESPACE_API_EXTERN ErrorContextApi *error_context PLUGIN_NAMESPACE_INIT
 PLUGIN_NAMESPACE_API_EXTERN ResourceManagerApi* resource_manager PLUGIN_NAMESPACE_INITIALIZE_API;
 PLUGIN_NAMESPACE_API_EXTERN ThreadApi* thread PLUGIN_NAMESPACE_INITIALIZE_API;
 PLUGIN_NAMESPACE_API_EXTERN ProfilerApi* profiler PLUGIN_NAMESPACE_INITIALIZE_API;
+PLUGIN_NAMESPACE_API_EXTERN TimerApi* timer PLUGIN_NAMESPACE_INITIALIZE_API;
 	
 PLUGIN_NAMESPACE_API_EXTERN DataCompilerApi *data_compiler PLUGIN_NAMESPACE_INITIALIZE_API;
 PLUGIN_NAMESPACE_API_EXTERN DataCompileParametersApi * data_compile_params PLUGIN_NAMESPACE_INITIALIZE_API;
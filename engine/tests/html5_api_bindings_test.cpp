@@ -0,0 +1,577 @@
+// Generated by tools/bindgen.rb from the BIND_API calls of engine/html5_api_*.cpp, do not edit.
+// Regenerate with `ruby tools/bindgen.rb`.
+//
+// Compile test: instantiates the argument decoding, call and result conversion of every bound
+// C API function, without creating handlers. Building this file alone checks all signatures.
+
+#include "../html5_api_bindings.h"
+
+namespace PLUGIN_NAMESPACE {
+
+template<typename F> void check_binding(F)
+{
+	uint64_t (*call)(F, const CefV8ValueList&, CefRefPtr<CefV8Value>&) = &call_f;
+	(void)call;
+}
+
+template<size_t K, typename F> void check_binding(const OutBufferFunction<K, F>&)
+{
+	uint64_t (*call)(const OutBufferFunction<K, F>&, const CefV8ValueList&, CefRefPtr<CefV8Value>&) = &call_f;
+	(void)call;
+}
+
+#define CHECK_BINDING(NAME) check_binding(api->NAME)
+#define CHECK_BINDING_OUT_BUFFER(NAME, INDEX) check_binding(out_buffer_function<INDEX>(api->NAME))
+
+// html5_api_actor.cpp
+void check_bind_api_actor(const ActorCApi* api)
+{
+	CHECK_BINDING(is_collision_enabled);
+	CHECK_BINDING(is_scene_query_enabled);
+	CHECK_BINDING(is_gravity_enabled);
+	CHECK_BINDING(set_collision_enabled);
+	CHECK_BINDING(set_scene_query_enabled);
+	CHECK_BINDING(set_gravity_enabled);
+	CHECK_BINDING(is_static);
+	CHECK_BINDING(is_dynamic);
+	CHECK_BINDING(is_physical);
+	CHECK_BINDING(is_kinematic);
+	CHECK_BINDING(set_kinematic);
+	CHECK_BINDING(mass);
+	CHECK_BINDING(linear_damping);
+	CHECK_BINDING(angular_damping);
+	CHECK_BINDING(set_linear_damping);
+	CHECK_BINDING(set_angular_damping);
+	CHECK_BINDING(center_of_mass);
+	CHECK_BINDING(position);
+	CHECK_BINDING(rotation);
+	CHECK_BINDING(pose);
+	CHECK_BINDING(teleport_position);
+	CHECK_BINDING(teleport_rotation);
+	CHECK_BINDING(teleport_pose);
+	CHECK_BINDING(set_velocity);
+	CHECK_BINDING(set_angular_velocity);
+	CHECK_BINDING(velocity);
+	CHECK_BINDING(angular_velocity);
+	CHECK_BINDING(point_velocity);
+	CHECK_BINDING(add_impulse);
+	CHECK_BINDING(add_velocity);
+	CHECK_BINDING(add_torque_impulse);
+	CHECK_BINDING(add_angular_velocity);
+	CHECK_BINDING(add_impulse_at);
+	CHECK_BINDING(add_velocity_at);
+	CHECK_BINDING(push);
+	CHECK_BINDING(push_at);
+	CHECK_BINDING(is_sleeping);
+	CHECK_BINDING(wake_up);
+	CHECK_BINDING(put_to_sleep);
+	CHECK_BINDING(debug_draw);
+	CHECK_BINDING(unit);
+	CHECK_BINDING(node);
+	CHECK_BINDING(set_collision_filter);
+	CHECK_BINDING(initial_shape_template);
+}
+
+// html5_api_application.cpp
+void check_bind_api_application(const ApplicationCApi* api)
+{
+	CHECK_BINDING(num_worlds);
+	CHECK_BINDING(world);
+	CHECK_BINDING(new_world);
+	CHECK_BINDING(main_world);
+	CHECK_BINDING(release_world);
+	CHECK_BINDING(render_world);
+	CHECK_BINDING(build);
+	CHECK_BINDING(platform);
+	CHECK_BINDING(build_identifier);
+	CHECK_BINDING(sysinfo);
+	CHECK_BINDING(create_viewport);
+	CHECK_BINDING(destroy_viewport);
+	CHECK_BINDING(time_since_launch);
+	CHECK_BINDING(sleep);
+	CHECK_BINDING(get_time_step_policy);
+	CHECK_BINDING(quit);
+}
+
+// html5_api_camera.cpp
+void check_bind_api_camera(const CameraCApi* api)
+{
+	CHECK_BINDING(local_position);
+	CHECK_BINDING(local_rotation);
+	CHECK_BINDING(local_scale);
+	CHECK_BINDING(local_pose);
+	CHECK_BINDING(set_local_position);
+	CHECK_BINDING(set_local_rotation);
+	CHECK_BINDING(set_local_scale);
+	CHECK_BINDING(set_local_pose);
+	CHECK_BINDING(world_position);
+	CHECK_BINDING(world_pose);
+	CHECK_BINDING(world_rotation);
+	CHECK_BINDING(near_range);
+	CHECK_BINDING(far_range);
+	CHECK_BINDING(set_near_range);
+	CHECK_BINDING(set_far_range);
+	CHECK_BINDING(vertical_fov);
+	CHECK_BINDING(set_vertical_fov);
+	CHECK_BINDING(projection_type);
+	CHECK_BINDING(set_projection_type);
+	CHECK_BINDING(set_orthographic_view);
+	CHECK_BINDING(set_post_projection_transform);
+	CHECK_BINDING(set_frustum);
+	CHECK_BINDING(set_frustum_half_angles);
+	CHECK_BINDING(inside_frustum);
+	CHECK_BINDING(node);
+	CHECK_BINDING(mode);
+	CHECK_BINDING(set_mode);
+	CHECK_BINDING(set_local);
+	CHECK_BINDING(screen_to_world);
+}
+
+// html5_api_gui.cpp
+void check_bind_api_gui(const GuiCApi* api)
+{
+	CHECK_BINDING(material);
+	CHECK_BINDING(create_material);
+	CHECK_BINDING(rect);
+	CHECK_BINDING(update_rect);
+	CHECK_BINDING(destroy_rect);
+	CHECK_BINDING(bitmap);
+	CHECK_BINDING(destroy_bitmap);
+#if 0 // TODO: incrementally add more apis.
+	CHECK_BINDING(triangle);
+	CHECK_BINDING(update_triangle);
+	CHECK_BINDING(destroy_triangle);
+	CHECK_BINDING(rect_3d);
+	CHECK_BINDING(update_rect_3d);
+	CHECK_BINDING(destroy_rect_3d);
+	CHECK_BINDING(bitmap_3d);
+	CHECK_BINDING(update_bitmap_3d);
+	CHECK_BINDING(destroy_bitmap_3d);
+	CHECK_BINDING(text);
+	CHECK_BINDING(update_text);
+	CHECK_BINDING(destroy_text);
+	CHECK_BINDING(text_3d);
+	CHECK_BINDING(update_text_3d);
+	CHECK_BINDING(destroy_text_3d);
+	CHECK_BINDING(text_extents);
+	CHECK_BINDING(word_wrap);
+	CHECK_BINDING(video);
+	CHECK_BINDING(update_video);
+	CHECK_BINDING(destroy_video);
+	CHECK_BINDING(video_3d);
+	CHECK_BINDING(update_video_3d);
+	CHECK_BINDING(destroy_video_3d);
+	CHECK_BINDING(set_visible);
+	CHECK_BINDING(is_visible);
+	CHECK_BINDING(has_all_glyphs);
+	CHECK_BINDING(move);
+	CHECK_BINDING(move_3d);
+	CHECK_BINDING(reset);
+	CHECK_BINDING(resolution);
+	CHECK_BINDING(color_rgb);
+	CHECK_BINDING(color_argb);
+	CHECK_BINDING(get_id);
+	CHECK_BINDING(set_video_playback_speed);
+	CHECK_BINDING(set_video_loop);
+	CHECK_BINDING(video_has_audio);
+	CHECK_BINDING(video_sound_stream_source);
+	CHECK_BINDING(video_number_of_frames);
+	CHECK_BINDING(video_current_frame);
+	CHECK_BINDING(video_times_looped);
+#if defined(DEVELOPMENT)
+	CHECK_BINDING(texture_size);
+	CHECK_BINDING(thumbnail_load_texture);
+	CHECK_BINDING(thumbnail_load_dds);
+	CHECK_BINDING(thumbnail_unload);
+#endif
+#endif
+}
+
+// html5_api_input.cpp
+void check_bind_api_input(const InputCApi* api)
+{
+	CHECK_BINDING(num_pads);
+	CHECK_BINDING(num_touch_panels);
+	CHECK_BINDING(num_windows_ps4_pads);
+	CHECK_BINDING(flush_controllers_state);
+	CHECK_BINDING(synergy_clipboard);
+	CHECK_BINDING(scan_for_windows_ps4_pads);
+	CHECK_BINDING(set_tablet_pen_service_properties);
+}
+
+// html5_api_level.cpp
+void check_bind_api_level(const LevelCApi* api)
+{
+	CHECK_BINDING(world);
+	CHECK_BINDING(spawn_background);
+	CHECK_BINDING(unit_by_index);
+	CHECK_BINDING(unit_index);
+	CHECK_BINDING(num_units);
+	CHECK_BINDING(num_nested_levels);
+	CHECK_BINDING(nested_level);
+	CHECK_BINDING(num_entities);
+	CHECK_BINDING(entity);
+	CHECK_BINDING(random_point_inside_volume);
+	CHECK_BINDING(next_random_point_inside_volume);
+	CHECK_BINDING(is_point_inside_volume);
+	CHECK_BINDING(has_volume);
+	CHECK_BINDING(flow_event);
+	CHECK_BINDING(flow_variable_type);
+	CHECK_BINDING(flow_variable);
+	CHECK_BINDING(set_flow_variable);
+	CHECK_BINDING(trigger_event);
+	CHECK_BINDING(trigger_level_loaded);
+	CHECK_BINDING(trigger_level_shutdown);
+	CHECK_BINDING(trigger_level_update);
+	CHECK_BINDING(pose);
+	CHECK_BINDING(navigation_mesh);
+	CHECK_BINDING(spline);
+	CHECK_BINDING(num_splines);
+	CHECK_BINDING(spline_by_index);
+#if defined(DEVELOPMENT)
+	CHECK_BINDING(set_pose);
+	CHECK_BINDING(set_visibility);
+	CHECK_BINDING(box);
+	CHECK_BINDING(num_internal_units);
+	CHECK_BINDING(internal_units);
+#endif
+}
+
+// html5_api_line_object.cpp
+void check_bind_api_line_object(const LineObjectCApi* api)
+{
+	CHECK_BINDING(dispatch);
+	CHECK_BINDING(reset);
+	CHECK_BINDING(add_line);
+	CHECK_BINDING(add_cone);
+	CHECK_BINDING(add_circle);
+	CHECK_BINDING(add_sphere);
+	CHECK_BINDING(add_half_sphere);
+	CHECK_BINDING(add_box);
+	CHECK_BINDING(add_capsule);
+	CHECK_BINDING(add_axes);
+	CHECK_BINDING(add_unit_meshes);
+}
+
+// html5_api_material.cpp
+void check_bind_api_material(const MaterialCApi* api)
+{
+	CHECK_BINDING(set_scalar);
+	CHECK_BINDING(set_vector2);
+	CHECK_BINDING(set_vector3);
+	CHECK_BINDING(set_vector4);
+	CHECK_BINDING(material_id);
+	CHECK_BINDING(set_shader_pass_flag);
+	CHECK_BINDING(set_texture);
+	CHECK_BINDING(set_resource);
+	CHECK_BINDING(set_matrix4x4);
+}
+
+// html5_api_mesh.cpp
+void check_bind_api_mesh(const MeshCApi* api)
+{
+	CHECK_BINDING(num_materials);
+	CHECK_BINDING(find_material);
+	CHECK_BINDING(material);
+	CHECK_BINDING(node);
+	CHECK_BINDING(set_shader_pass_flag);
+	CHECK_BINDING(bounding_volume);
+	CHECK_BINDING(set_explicit_sort_value);
+	CHECK_BINDING(local_position);
+	CHECK_BINDING(local_rotation);
+	CHECK_BINDING(local_scale);
+	CHECK_BINDING(local_pose);
+	CHECK_BINDING(set_local_position);
+	CHECK_BINDING(set_local_rotation);
+	CHECK_BINDING(set_local_scale);
+	CHECK_BINDING(set_local_pose);
+	CHECK_BINDING(world_position);
+	CHECK_BINDING(world_pose);
+	CHECK_BINDING(world_rotation);
+}
+
+// html5_api_mover.cpp
+void check_bind_api_mover(const MoverCApi* api)
+{
+	CHECK_BINDING(unit);
+	CHECK_BINDING(set_position);
+	CHECK_BINDING(position);
+	CHECK_BINDING(move);
+	CHECK_BINDING(separate);
+	CHECK_BINDING(fits_at);
+	CHECK_BINDING(collides_down);
+	CHECK_BINDING(collides_up);
+	CHECK_BINDING(collides_sides);
+	CHECK_BINDING(actor_colliding_down);
+	CHECK_BINDING(standing_frames);
+	CHECK_BINDING(flying_frames);
+	CHECK_BINDING(set_collision_filter);
+	CHECK_BINDING(max_slope_angle);
+	CHECK_BINDING(set_max_slope_angle);
+	CHECK_BINDING(radius);
+}
+
+// html5_api_physics_world.cpp
+void check_bind_api_physics_world(const PhysicsWorldCApi* api)
+{
+	CHECK_BINDING_OUT_BUFFER(raycast, 0);
+	CHECK_BINDING_OUT_BUFFER(cast, 1);
+	CHECK_BINDING(make_raycast);
+	CHECK_BINDING(destroy_raycast);
+	CHECK_BINDING_OUT_BUFFER(overlap, 0);
+	CHECK_BINDING_OUT_BUFFER(linear_sphere_sweep, 0);
+	CHECK_BINDING_OUT_BUFFER(linear_capsule_sweep, 0);
+	CHECK_BINDING_OUT_BUFFER(linear_obb_sweep, 0);
+}
+
+// html5_api_unit.cpp
+void check_bind_api_unit(const UnitCApi* api)
+{
+	CHECK_BINDING(local_position);
+	CHECK_BINDING(local_rotation);
+	CHECK_BINDING(local_scale);
+	CHECK_BINDING(local_pose);
+	CHECK_BINDING(set_local_position);
+	CHECK_BINDING(set_local_rotation);
+	CHECK_BINDING(set_local_scale);
+	CHECK_BINDING(set_local_pose);
+	CHECK_BINDING(world_position);
+	CHECK_BINDING(world_pose);
+	CHECK_BINDING(world_rotation);
+	CHECK_BINDING(teleport_local_position);
+	CHECK_BINDING(teleport_local_rotation);
+	CHECK_BINDING(teleport_local_scale);
+	CHECK_BINDING(teleport_local_pose);
+	CHECK_BINDING(delta_position);
+	CHECK_BINDING(delta_rotation);
+	CHECK_BINDING(delta_pose);
+	CHECK_BINDING(create_actor);
+	CHECK_BINDING(destroy_actor);
+	CHECK_BINDING(num_actors);
+	CHECK_BINDING(find_actor);
+	CHECK_BINDING(actor);
+	CHECK_BINDING(num_movers);
+	CHECK_BINDING(find_mover);
+	CHECK_BINDING(set_mover);
+	CHECK_BINDING(set_mover_to_none);
+	CHECK_BINDING(mover);
+	CHECK_BINDING(mover_fits_at);
+	CHECK_BINDING(trigger_flow_event);
+	CHECK_BINDING(flow_variable);
+	CHECK_BINDING(set_flow_variable);
+	CHECK_BINDING(trigger_unit_spawned);
+	CHECK_BINDING(set_material);
+	CHECK_BINDING(set_material_to_none);
+	CHECK_BINDING(query_material);
+	CHECK_BINDING(save_instance_material_data);
+	CHECK_BINDING(restore_instance_material_data);
+	CHECK_BINDING(is_using_material_set);
+	CHECK_BINDING(num_meshes);
+	CHECK_BINDING(find_mesh);
+	CHECK_BINDING(mesh);
+	CHECK_BINDING(bones);
+	CHECK_BINDING(animation_wanted_root_pose);
+	CHECK_BINDING(animation_set_bones_lod);
+	CHECK_BINDING(animation_root_mode);
+	CHECK_BINDING(animation_bone_mode);
+	CHECK_BINDING(set_animation_root_mode);
+	CHECK_BINDING(set_animation_bone_mode);
+	CHECK_BINDING(animation_find_constraint_target);
+	CHECK_BINDING(animation_has_constraint_target);
+	CHECK_BINDING(animation_get_constraint_target);
+	CHECK_BINDING(animation_set_constraint_target_pose);
+	CHECK_BINDING(animation_set_constraint_target_position);
+	CHECK_BINDING(animation_set_constraint_target_rotation);
+	CHECK_BINDING(crossfade_animation);
+	CHECK_BINDING(is_crossfading_animation);
+	CHECK_BINDING(crossfade_animation_set_time);
+	CHECK_BINDING(crossfade_animation_set_speed);
+	CHECK_BINDING(disable_animation_state_machine);
+	CHECK_BINDING(enable_animation_state_machine);
+	CHECK_BINDING(set_animation_state_machine);
+	CHECK_BINDING(has_animation_state_machine);
+	CHECK_BINDING(has_animation_event);
+	CHECK_BINDING(animation_trigger_event);
+	CHECK_BINDING(animation_trigger_event_with_parameters);
+	CHECK_BINDING(animation_find_variable);
+	CHECK_BINDING(animation_has_variable);
+	CHECK_BINDING(animation_get_variable);
+	CHECK_BINDING(animation_set_variable);
+	CHECK_BINDING(animation_set_state);
+	CHECK_BINDING(animation_get_state);
+	CHECK_BINDING(animation_set_seeds);
+	CHECK_BINDING(animation_get_seeds);
+	CHECK_BINDING(animation_layer_info);
+	CHECK_BINDING(set_animation_merge_options);
+	CHECK_BINDING(animation_set_moving);
+	CHECK_BINDING(set_animation_logging);
+	CHECK_BINDING(play_simple_animation);
+	CHECK_BINDING(stop_simple_animation);
+	CHECK_BINDING(num_terrains);
+	CHECK_BINDING(find_terrain);
+	CHECK_BINDING(terrain);
+	CHECK_BINDING(terrain_update_height_field);
+	CHECK_BINDING(create_joint);
+	CHECK_BINDING(destroy_joint);
+	CHECK_BINDING(create_custom_joint);
+	CHECK_BINDING(num_scene_graph_items);
+	CHECK_BINDING(find_scene_graph_parent);
+	CHECK_BINDING(scene_graph_link);
+	CHECK_BINDING(scene_graph_link_to_none);
+	CHECK_BINDING(copy_scene_graph_local_from);
+	CHECK_BINDING(num_lod_objects);
+	CHECK_BINDING(find_lod_object);
+	CHECK_BINDING(lod_object);
+	CHECK_BINDING(num_steps_lod);
+	CHECK_BINDING(num_mesh_lod_step);
+	CHECK_BINDING(lod_step_meshes);
+	CHECK_BINDING(num_lights);
+	CHECK_BINDING(find_light);
+	CHECK_BINDING(light);
+	CHECK_BINDING(set_light_material);
+	CHECK_BINDING(create_vehicle);
+	CHECK_BINDING(destroy_vehicle);
+	CHECK_BINDING(has_vehicle);
+	CHECK_BINDING(vehicle);
+	CHECK_BINDING(enable_physics);
+	CHECK_BINDING(disable_physics);
+	CHECK_BINDING(apply_initial_actor_velocities);
+	CHECK_BINDING(set_unit_visibility);
+	CHECK_BINDING(set_mesh_visibility);
+	CHECK_BINDING(set_cloth_visibility);
+	CHECK_BINDING(set_visibility_group);
+	CHECK_BINDING(has_visibility_group);
+	CHECK_BINDING(create_cloth);
+	CHECK_BINDING(destroy_cloth);
+	CHECK_BINDING(num_cloths);
+	CHECK_BINDING(find_cloth);
+	CHECK_BINDING(cloth);
+	CHECK_BINDING(num_cameras);
+	CHECK_BINDING(find_camera);
+	CHECK_BINDING(camera);
+	CHECK_BINDING(has_node);
+	CHECK_BINDING(node);
+	CHECK_BINDING(resource_has_node);
+	CHECK_BINDING(resource_node);
+	CHECK_BINDING(resource_local_pose);
+	CHECK_BINDING(world);
+	CHECK_BINDING(level);
+	CHECK_BINDING(is_alive);
+	CHECK_BINDING(id_in_level);
+	CHECK_BINDING(is_of_resource_type);
+	CHECK_BINDING(unit_name_s);
+	CHECK_BINDING(box);
+	CHECK_BINDING(debug_name);
+	CHECK_BINDING(is_a);
+	CHECK_BINDING(set_id_in_level);
+	CHECK_BINDING(draw_tree);
+}
+
+// html5_api_viewport.cpp
+void check_bind_api_viewport(const ViewportCApi* api)
+{
+	CHECK_BINDING(set_rect);
+}
+
+// html5_api_window.cpp
+void check_bind_api_window(const WindowCApi* api)
+{
+	CHECK_BINDING(has_mouse_focus);
+	CHECK_BINDING(has_focus);
+	CHECK_BINDING(set_mouse_focus);
+	CHECK_BINDING(set_focus);
+	CHECK_BINDING(show_cursor);
+	CHECK_BINDING(clip_cursor);
+	CHECK_BINDING(set_cursor);
+	CHECK_BINDING(set_show_cursor);
+	CHECK_BINDING(set_clip_cursor);
+	CHECK_BINDING(is_resizable);
+	CHECK_BINDING(set_resizable);
+	CHECK_BINDING(set_resolution);
+	CHECK_BINDING(get_dpi_scale);
+	CHECK_BINDING(set_title);
+	CHECK_BINDING(has_window);
+	CHECK_BINDING(get_main_window);
+	CHECK_BINDING(minimize);
+	CHECK_BINDING(maximize);
+	CHECK_BINDING(restore);
+	CHECK_BINDING(is_closing);
+	CHECK_BINDING(close);
+	CHECK_BINDING(get_main_window);
+	CHECK_BINDING(trigger_resize);
+	CHECK_BINDING(set_ime_enabled);
+	CHECK_BINDING(set_foreground);
+	CHECK_BINDING(set_keystroke_enabled);
+	CHECK_BINDING(id);
+	CHECK_BINDING(rect);
+	CHECK_BINDING(set_rect);
+	CHECK_BINDING(open);
+}
+
+// html5_api_world.cpp
+void check_bind_api_world(const WorldCApi* api)
+{
+	CHECK_BINDING(spawn_unit);
+	CHECK_BINDING(destroy_unit);
+	CHECK_BINDING(num_units);
+	CHECK_BINDING(unit_by_name);
+	CHECK_BINDING(unit_by_id);
+	CHECK_BINDING(unit_by_index);
+	CHECK_BINDING(num_units_by_resource);
+	CHECK_BINDING(units_by_resource);
+	CHECK_BINDING(link_unit);
+	CHECK_BINDING(unlink_unit);
+	CHECK_BINDING(update_unit);
+	CHECK_BINDING(create_particles);
+	CHECK_BINDING(destroy_particles);
+	CHECK_BINDING(stop_spawning_particles);
+	CHECK_BINDING(are_particles_playing);
+	CHECK_BINDING(set_particles_collision_filter);
+	CHECK_BINDING(move_particles);
+	CHECK_BINDING(link_particles);
+	CHECK_BINDING(find_particles_variable);
+	CHECK_BINDING(set_particles_variable);
+	CHECK_BINDING(load_level);
+	CHECK_BINDING(destroy_level);
+	CHECK_BINDING(num_levels);
+	CHECK_BINDING(level);
+	CHECK_BINDING(update);
+	CHECK_BINDING(update_animations);
+	CHECK_BINDING(update_scene);
+	CHECK_BINDING(delta_time);
+	CHECK_BINDING(time);
+	CHECK_BINDING(storyteller);
+	CHECK_BINDING(vector_field);
+	CHECK_BINDING(scatter_system);
+	CHECK_BINDING(set_flow_enabled);
+	CHECK_BINDING(set_editor_flow_enabled);
+	CHECK_BINDING(create_shading_environment);
+	CHECK_BINDING(create_default_shading_environment);
+	CHECK_BINDING(destroy_shading_environment);
+	CHECK_BINDING(set_shading_environment);
+	CHECK_BINDING(create_screen_gui);
+	CHECK_BINDING(create_world_gui);
+	CHECK_BINDING(destroy_gui);
+	CHECK_BINDING(physics_world);
+	CHECK_BINDING(debug_camera_pose);
+#if defined(DEVELOPMENT)
+	CHECK_BINDING(set_flow_enabled);
+	CHECK_BINDING(set_editor_flow_enabled);
+	CHECK_BINDING(num_particles);
+	CHECK_BINDING(advance_particles_time);
+	CHECK_BINDING(set_frustum_inspector_camera);
+	CHECK_BINDING(replay);
+	CHECK_BINDING(start_playback);
+	CHECK_BINDING(stop_playback);
+	CHECK_BINDING(is_playing_back);
+	CHECK_BINDING(num_frames);
+	CHECK_BINDING(frame);
+	CHECK_BINDING(set_frame);
+	CHECK_BINDING(record_debug_line);
+	CHECK_BINDING(record_screen_debug_text);
+	CHECK_BINDING(record_world_debug_text);
+	CHECK_BINDING(set_unit_record_mode);
+#endif
+}
+
+} // end namespace
@@ -0,0 +1,109 @@
+// Test of EngineGate: page calls must never run while the engine runs its frame, including calls that start
+// after the engine skipped its wait.
+
+#include "../html5_engine_gate.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+static const unsigned PAGE_COUNT = 2;
+static const unsigned FRAME_COUNT = 1000;
+
+static std::atomic<unsigned> failures(0);
+
+// Runs the queued calls only if the engine is held, like the async batch does.
+static unsigned run_batch(EngineGate& gate, std::deque<int>& calls)
+{
+	if (!gate.enter())
+		return 0;
+	unsigned ran = 0;
+	while (!calls.empty()) {
+		calls.pop_front();
+		++ran;
+	}
+	gate.leave();
+	return ran;
+}
+
+static int run()
+{
+	int result = 0;
+
+	// The engine skipped its wait before the batch started, the calls stay queued for the next frame.
+	{
+		EngineGate gate;
+		std::deque<int> calls = { 1, 2, 3 };
+		gate.open();
+		gate.close();
+		if (run_batch(gate, calls) != 0 || calls.size() != 3) {
+			printf("FAIL: batch ran after a skipped wait\n");
+			result = 1;
+		}
+		gate.open();
+		if (run_batch(gate, calls) != 3 || !calls.empty()) {
+			printf("FAIL: batch didn't run while the engine waits\n");
+			result = 1;
+		}
+		gate.close();
+	}
+
+	// Pages keep calling while the engine alternates between waiting and running its frame.
+	EngineGate gate;
+	std::atomic<bool> frame_running(true);
+	std::atomic<bool> running(true);
+	std::atomic<unsigned> entered(0);
+
+	std::vector<std::thread> pages;
+	for (unsigned i = 0; i < PAGE_COUNT; ++i) {
+		pages.emplace_back([&]() {
+			while (running.load()) {
+				if (gate.enter()) {
+					for (unsigned spin = 0; spin < 16; ++spin) {
+						if (frame_running.load())
+							++failures;
+					}
+					++entered;
+					gate.leave();
+				}
+				std::this_thread::yield();
+			}
+		});
+	}
+
+	for (unsigned frame = 0; frame < FRAME_COUNT; ++frame) {
+		frame_running = false;
+		gate.open();
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		gate.close();
+		frame_running = true;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	running = false;
+	for (auto& page : pages)
+		page.join();
+
+	if (failures.load() != 0) {
+		printf("FAIL: %u page calls ran during the engine frame\n", failures.load());
+		result = 1;
+	}
+	if (gate.is_open()) {
+		printf("FAIL: gate left open\n");
+		result = 1;
+	}
+	printf("%u frames, %u page calls entered\n", FRAME_COUNT, entered.load());
+	return result;
+}
+
+} // end namespace
+
+int main()
+{
+	return PLUGIN_NAMESPACE::run();
+}
@@ -0,0 +1,94 @@
+// Stress test of ReadMostly: readers keep overlapping while a writer publishes, retired values must be
+// freed during the run and never while a reader still reads them.
+
+#include "../html5_read_mostly.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace PLUGIN_NAMESPACE {
+
+static const unsigned READER_COUNT = 8;
+static const unsigned PUBLISH_COUNT = 100000;
+static const unsigned ALIVE = 0xa11ca7ed;
+
+struct Value
+{
+	unsigned alive;
+	unsigned version;
+};
+
+static std::atomic<unsigned> freed(0);
+static std::atomic<unsigned> failures(0);
+
+static void free_value(Value* value)
+{
+	value->alive = 0;
+	delete value;
+	++freed;
+}
+
+static int run()
+{
+	ReadMostly<Value> value(new Value{ ALIVE, 0 }, free_value);
+	std::atomic<bool> running(true);
+
+	// Readers overlap, so there is never a moment without one.
+	std::vector<std::thread> readers;
+	for (unsigned i = 0; i < READER_COUNT; ++i) {
+		readers.emplace_back([&value, &running]() {
+			unsigned last_version = 0;
+			while (running.load()) {
+				ReadMostly<Value>::ReadSection read(value);
+				for (unsigned spin = 0; spin < 64; ++spin) {
+					if (read->alive != ALIVE)
+						++failures;
+				}
+				if (read->version < last_version)
+					++failures;
+				last_version = read->version;
+			}
+		});
+	}
+
+	unsigned max_retired = 0;
+	for (unsigned i = 1; i <= PUBLISH_COUNT; ++i) {
+		value.publish(new Value{ ALIVE, i });
+		if (value.retired_count() > max_retired)
+			max_retired = value.retired_count();
+	}
+	const unsigned freed_while_reading = freed.load();
+
+	running = false;
+	for (auto& reader : readers)
+		reader.join();
+
+	// With no reader left, two more reclaims free everything retired.
+	value.reclaim();
+	value.reclaim();
+
+	int result = 0;
+	if (failures.load() != 0) {
+		printf("FAIL: %u reads of freed or older values\n", failures.load());
+		result = 1;
+	}
+	if (freed_while_reading == 0) {
+		printf("FAIL: nothing was freed while readers overlapped\n");
+		result = 1;
+	}
+	if (value.retired_count() != 0 || freed.load() != PUBLISH_COUNT) {
+		printf("FAIL: %u retired values left, %u of %u freed\n", value.retired_count(), freed.load(), PUBLISH_COUNT);
+		result = 1;
+	}
+	printf("%u published, %u freed while reading, at most %u retired at once\n", PUBLISH_COUNT, freed_while_reading, max_retired);
+	return result;
+}
+
+} // end namespace
+
+int main()
+{
+	return PLUGIN_NAMESPACE::run();
+}
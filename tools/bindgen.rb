@@ -0,0 +1,252 @@
+#!/usr/bin/env ruby
+#******************************************************************************
+#
+# bindgen.rb - Generate JavaScript bindings from the engine C API headers
+#
+# Reads `stingray_sdk/engine_plugin_api/c_api/c_api_<name>.h`, extracts the
+# function pointers of the `<Name>CApi` struct and writes
+# `engine/html5_api_<name>.cpp` with a `bind_api_<name>` function. Each
+# supported function is bound with `BIND_API`, which instantiates a
+# `create_handler` specialized on the exact function signature.
+#
+# Functions using argument or result types the marshaling layer in
+# `html5_api_bindings.h` does not know about are emitted as comments, so a
+# regenerated file shows what is left to do.
+#
+# Usage: ruby tools/bindgen.rb [--check] [name ...]
+#
+# With --check nothing is written, the script fails if a generated file
+# differs from what the headers produce. The engine build runs it.
+#
+#******************************************************************************
+
+$script_dir = File.expand_path(File.dirname(__FILE__))
+$repo_dir = File.expand_path(File.join($script_dir, ".."))
+$c_api_dir = File.join($repo_dir, "stingray_sdk", "engine_plugin_api", "c_api")
+$engine_dir = File.join($repo_dir, "engine")
+
+# Namespaces generated when no name is given on the command line.
+$default_namespaces = ["material", "mesh", "physics_world", "actor", "mover", "viewport", "line_object"]
+
+# Types `get_arg` can decode, after typedef resolution.
+$argument_types = [
+	"int", "unsigned", "float", "uint64_t", "const char *", "int *", "unsigned *", "void *", "const void *",
+	"CApiVector2", "CApiVector3", "CApiVector4", "CApiQuaternion", "CApiMatrix4x4",
+	"const CApiVector2 *", "const CApiVector3 *", "const CApiVector4 *", "const CApiQuaternion *", "const CApiMatrix4x4 *",
+	"CApiWorld *", "CApiLevel *", "CApiViewport *", "CApiCamera *", "CApiWindow *", "CApiMover *", "CApiMaterial *",
+	"CApiActor *", "CApiLight *", "CApiGui *", "CApiMesh *", "CApiLineObject *", "CApiPhysicsWorld *",
+	"CApiLocalTransform *",
+	"const CApiWorld *", "const CApiLevel *", "const CApiViewport *", "const CApiCamera *", "const CApiWindow *",
+	"const CApiMaterial *", "const CApiMesh *", "const CApiLocalTransform *",
+	"RaycastType", "ActorTemplate", "OverlapShape"
+]
+
+# Types `wrap_result` can convert back to JavaScript values.
+$result_types = [
+	"void", "int", "unsigned", "float", "double", "uint64_t", "const char *", "void *", "const void *",
+	"CApiVector2", "CApiVector3", "CApiVector4", "CApiQuaternion", "CApiMatrix4x4",
+	"const CApiVector2 *", "const CApiVector3 *", "const CApiMatrix4x4 *", "const CApiLocalTransform *",
+	"MoverFitsAtResult", "MoverSeparateResult", "BoundingVolumeWrapper",
+	"CApiActor *", "CApiMaterial *", "CApiMesh *", "CApiMover *", "CApiWorld *", "CApiLevel *", "CApiPhysicsWorld *"
+]
+
+# Item types of out buffers `wrap_result` can convert, functions filling them return the items as an array.
+$out_buffer_types = ["CollisionHit *", "CApiActor * *"]
+
+def camel_case(name)
+	name.split("_").map { |w| w[0].upcase + w[1..-1] }.join
+end
+
+def normalize_type(type)
+	type.gsub(/\b(struct|enum)\s+/, "").gsub(/\s*\*\s*/, " *").gsub(/\s+/, " ").strip
+end
+
+# Parses `typedef X Y;` lines of c_api_types.h and plugin_api_types.h to resolve aliases.
+def load_typedefs
+	typedefs = {}
+	[File.join($c_api_dir, "c_api_types.h"), File.join($c_api_dir, "..", "plugin_api_types.h")].each do |path|
+		IO.read(path).scan(/typedef\s+([\w\s\*]+?)\s*\b(\w+)\s*;/) do |source, name|
+			source = normalize_type(source)
+			typedefs[name] = source unless source.empty? || source == name
+		end
+	end
+	typedefs["ParticleRef"] = "unsigned"
+	typedefs
+end
+
+def resolve_type(type, typedefs)
+	type = normalize_type(type)
+	const = type.start_with?("const ")
+	base = type.sub(/^const /, "")
+	pointer = base.end_with?(" *") ? " *" : ""
+	base = base.sub(/ \*$/, "")
+	while typedefs.key?(base)
+		resolved = typedefs[base]
+		if resolved.end_with?(" *")
+			pointer += " *"
+			resolved = resolved.sub(/ \*$/, "")
+		end
+		const ||= resolved.start_with?("const ")
+		base = resolved.sub(/^const /, "")
+	end
+	base = "unsigned" if base == "unsigned int"
+	normalize_type((const ? "const " : "") + base + pointer)
+end
+
+# Strips the parameter name, if any, to keep the parameter type.
+def parameter_type(param)
+	param = param.strip
+	array = param.sub!(/\s*\[\s*\]$/, "") != nil
+	words = param.scan(/\w+/).reject { |w| ["const", "struct", "enum", "signed", "long", "short"].include?(w) }
+	words.delete("int") if words.include?("unsigned")
+	param = param.sub(/\s*\b\w+$/, "") if words.length > 1
+	normalize_type(param + (array ? " *" : ""))
+end
+
+def parse_functions(header_path, struct_name)
+	source = IO.read(header_path)
+	source = source.gsub(%r{/\*.*?\*/}m, "").gsub(%r{//[^\n]*}, "")
+	body = source[/struct\s+#{struct_name}\s*\{(.*?)\};/m, 1]
+	raise "Cannot find struct #{struct_name} in `#{header_path}`" if body.nil?
+
+	functions = []
+	body.scan(/([\w\s\*]+?)\s*\(\s*\*\s*(\w+)\s*\)\s*\(([^;]*?)\)\s*;/m) do |result, name, params|
+		params = params.gsub(/\s+/, " ").strip
+		params = "" if params == "void"
+		functions << {
+			:name => name,
+			:result => normalize_type(result),
+			:params => params.empty? ? [] : params.split(",").map { |p| parameter_type(p) }
+		}
+	end
+	functions
+end
+
+# Returns the index of the `T* out_buffer, unsigned num_elements` pair of a function, or nil if it has none.
+def out_buffer_index(function, typedefs)
+	return nil unless resolve_type(function[:result], typedefs) == "unsigned"
+	params = function[:params].map { |p| resolve_type(p, typedefs) }
+	params.each_index.find { |i| $out_buffer_types.include?(params[i]) && params[i + 1] == "unsigned" }
+end
+
+def unsupported_reason(function, typedefs)
+	out_buffer = out_buffer_index(function, typedefs)
+	result = resolve_type(function[:result], typedefs)
+	return "unsupported result `#{function[:result]}`" unless out_buffer || $result_types.include?(result)
+	function[:params].each_with_index do |param, i|
+		next if out_buffer && (i == out_buffer || i == out_buffer + 1)
+		return "unsupported argument `#{param}`" unless $argument_types.include?(resolve_type(param, typedefs))
+	end
+	nil
+end
+
+def generate(name, typedefs)
+	header = "c_api_#{name}.h"
+	api_name = camel_case(name)
+	struct_name = "#{api_name}CApi"
+	functions = parse_functions(File.join($c_api_dir, header), struct_name)
+
+	lines = []
+	lines << "// Generated by tools/bindgen.rb from #{header}, do not edit."
+	lines << "// Regenerate with `ruby tools/bindgen.rb #{name}`."
+	lines << ""
+	lines << "#include \"html5_api_bindings.h\""
+	lines << ""
+	lines << "namespace PLUGIN_NAMESPACE {"
+	lines << ""
+	lines << "void bind_api_#{name}(CefRefPtr<CefV8Value> stingray_ns, const #{struct_name}* api)"
+	lines << "{"
+	lines << "\tDEFINE_API(\"#{api_name}\");"
+	lines << ""
+	functions.each do |function|
+		reason = unsupported_reason(function, typedefs)
+		out_buffer = out_buffer_index(function, typedefs)
+		if reason.nil? && out_buffer
+			lines << "\tBIND_API_OUT_BUFFER(#{function[:name]}, #{out_buffer});"
+		elsif reason.nil?
+			lines << "\tBIND_API(#{function[:name]});"
+		else
+			lines << "\t//BIND_API(#{function[:name]}); // #{reason}"
+		end
+	end
+	lines << "}"
+	lines << ""
+	lines << "} // end namespace"
+
+	write_source(File.join($engine_dir, "html5_api_#{name}.cpp"), lines, "ruby tools/bindgen.rb #{name}")
+end
+
+# Writes a generated file, or with --check only tells whether it is up to date.
+def write_source(path, lines, command)
+	source = lines.join("\n") + "\n"
+	if $check
+		return true if File.exist?(path) && IO.binread(path) == source
+		puts "#{path} is out of date, regenerate it with `#{command}`"
+		return false
+	end
+	File.open(path, "wb") { |file| file.write(source) }
+	puts "Generated #{path}"
+	true
+end
+
+# Writes the compile test instantiating every function bound with BIND_API or BIND_API_OUT_BUFFER,
+# generated or not. Preprocessor conditions around the bindings are kept.
+def generate_bindings_test
+	lines = []
+	lines << "// Generated by tools/bindgen.rb from the BIND_API calls of engine/html5_api_*.cpp, do not edit."
+	lines << "// Regenerate with `ruby tools/bindgen.rb`."
+	lines << "//"
+	lines << "// Compile test: instantiates the argument decoding, call and result conversion of every bound"
+	lines << "// C API function, without creating handlers. Building this file alone checks all signatures."
+	lines << ""
+	lines << "#include \"../html5_api_bindings.h\""
+	lines << ""
+	lines << "namespace PLUGIN_NAMESPACE {"
+	lines << ""
+	lines << "template<typename F> void check_binding(F)"
+	lines << "{"
+	lines << "\tuint64_t (*call)(F, const CefV8ValueList&, CefRefPtr<CefV8Value>&) = &call_f;"
+	lines << "\t(void)call;"
+	lines << "}"
+	lines << ""
+	lines << "template<size_t K, typename F> void check_binding(const OutBufferFunction<K, F>&)"
+	lines << "{"
+	lines << "\tuint64_t (*call)(const OutBufferFunction<K, F>&, const CefV8ValueList&, CefRefPtr<CefV8Value>&) = &call_f;"
+	lines << "\t(void)call;"
+	lines << "}"
+	lines << ""
+	lines << "#define CHECK_BINDING(NAME) check_binding(api->NAME)"
+	lines << "#define CHECK_BINDING_OUT_BUFFER(NAME, INDEX) check_binding(out_buffer_function<INDEX>(api->NAME))"
+	Dir.glob(File.join($engine_dir, "html5_api_*.cpp")).sort.each do |path|
+		source = IO.read(path)
+		source.scan(/^void (bind_api_\w+)\(CefRefPtr<CefV8Value> \w+, const (\w+)\* api\)\s*\{(.*?)^\}/m) do |function, struct_name, body|
+			checks = []
+			body.each_line do |line|
+				if line =~ /^\s*BIND_API\((\w+)\);/
+					checks << "\tCHECK_BINDING(#{$1});"
+				elsif line =~ /^\s*BIND_API_OUT_BUFFER\((\w+), (\d+)\);/
+					checks << "\tCHECK_BINDING_OUT_BUFFER(#{$1}, #{$2});"
+				elsif line =~ /^\s*(#\s*(if|ifdef|ifndef|elif|else|endif)\b.*?)\s*$/
+					checks << $1
+				end
+			end
+			next if checks.none? { |check| check.start_with?("\t") }
+			lines << ""
+			lines << "// #{File.basename(path)}"
+			lines << "void check_#{function}(const #{struct_name}* api)"
+			lines << "{"
+			lines.concat(checks)
+			lines << "}"
+		end
+	end
+	lines << ""
+	lines << "} // end namespace"
+	write_source(File.join($engine_dir, "tests", "html5_api_bindings_test.cpp"), lines, "ruby tools/bindgen.rb")
+end
+
+$check = ARGV.delete("--check") != nil
+names = ARGV.empty? ? $default_namespaces : ARGV
+typedefs = load_typedefs()
+up_to_date = names.map { |name| generate(name, typedefs) }.all?
+up_to_date = generate_bindings_test() && up_to_date
+exit 1 unless up_to_date